@@ -27,6 +27,7 @@
 
 #include <windows.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <time.h>
 
 /////////////////////////////////////////////////////////////////
@@ -45,6 +46,7 @@
 
 #include "nip24_error.h"
 #include "nip24_validate.h"
+#include "nip24_key.h"
 #include "nip24_invoice.h"
 #include "nip24_partner.h"
 #include "nip24_pkd.h"
@@ -56,6 +58,8 @@
 #include "nip24_vatentity.h"
 #include "nip24_search.h"
 #include "nip24_account.h"
+#include "nip24_cache.h"
+#include "nip24_batch.h"
 #include "nip24_client.h"
 
 /////////////////////////////////////////////////////////////////
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#ifndef __NIP24_API_BATCH_H__
+#define __NIP24_API_BATCH_H__
+
+/////////////////////////////////////////////////////////////////
+
+/**
+ * Zadanie przetwarzania wsadowego (zob. nip24_batch). Pola IBAN i Date dotycza metod
+ * NIP24_ENDPOINT_IBAN i NIP24_ENDPOINT_WHITELIST (Date rowniez NIP24_ENDPOINT_SEARCH, 0 - biezacy
+ * dzien), pole Force metod NIP24_ENDPOINT_INVOICE, NIP24_ENDPOINT_ALL i NIP24_ENDPOINT_VAT.
+ * Metoda NIP24_ENDPOINT_VIES pomija pole Type (Value to numer EU VAT ID).
+ */
+typedef struct BatchJob {
+	Endpoint Method;
+	Number Type;
+	const char* Value;
+
+	const char* IBAN;
+	time_t Date;
+
+	BOOL Force;
+} BatchJob;
+
+/**
+ * Wynik zadania przetwarzania wsadowego. Data wskazuje obiekt zwrocony przez metode API
+ * (InvoiceData, AllData, VIESData, VATStatus, IBANStatus, WLStatus lub SearchResult), Active
+ * zawiera wynik metody NIP24_ENDPOINT_ACTIVE. ErrCode rowny 0 oznacza poprawne wykonanie zadania,
+ * NIP24_ERR_CLI_CANCELLED - zadanie pominiete po przerwaniu przetwarzania.
+ */
+typedef struct BatchResult {
+	Endpoint Method;
+
+	void* Data;
+	BOOL Active;
+
+	int ErrCode;
+	char* Err;
+} BatchResult;
+
+/////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Dealokacja tablicy wynikow przetwarzania wsadowego
+ * @param results adres na tablice wynikow
+ * @param count liczba elementow tablicy
+ */
+NIP24_API void batchresult_free(BatchResult** results, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/////////////////////////////////////////////////////////////////
+
+#endif
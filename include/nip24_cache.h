@@ -0,0 +1,206 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#ifndef __NIP24_API_CACHE_H__
+#define __NIP24_API_CACHE_H__
+
+/////////////////////////////////////////////////////////////////
+
+/**
+ * Metody API, ktorych odpowiedzi moga byc przechowywane w pamieci podrecznej
+ */
+typedef enum Endpoint {
+	NIP24_ENDPOINT_INVOICE = 0,
+	NIP24_ENDPOINT_ALL,
+	NIP24_ENDPOINT_VIES,
+	NIP24_ENDPOINT_VAT,
+	NIP24_ENDPOINT_IBAN,
+	NIP24_ENDPOINT_WHITELIST,
+	NIP24_ENDPOINT_SEARCH,
+	NIP24_ENDPOINT_ACTIVE,
+	NIP24_ENDPOINT_COUNT
+} Endpoint;
+
+#define NIP24_ENDPOINT_FLAG(e)		(1u << (e))
+
+/**
+ * Pamiec podreczna odpowiedzi serwisu (LRU z czasem waznosci wpisow i dopuszczaniem nowych
+ * wpisow wg przyblizonej czestosci zapytan - TinyLFU), moze byc wspoldzielona
+ * przez wielu klientow (rowniez roznych kont). Kluczem jest metoda API, znormalizowany numer
+ * firmy, numer IBAN i dzien, ktorego dotyczy zapytanie - dane firm nie zaleza od konta, a bledy
+ * uprawnien, planu i autoryzacji nie sa zapamietywane. Do klienta dolaczana przez przypisanie
+ * pola NIP24Client::cache, klient jej nie zwalnia. Klienci korzystajacy z tej samej pamieci
+ * podrecznej nie powtarzaja jednoczesnych zapytan o ten sam adres - odpowiedz pierwszego
+ * zapytania otrzymuja wszyscy oczekujacy (po bledzie zaleznym od konta wysylaja wlasne
+ * zapytanie). Brakujace odpowiedzi nip24_get_invoice_data,
+ * nip24_get_vat_status i nip24_get_whitelist_status sa wyznaczane z zapamietanych pelniejszych
+ * odpowiedzi (nip24_get_all_data, nip24_search_vat_registry) i oznaczane polem Derived.
+ * Numery REGON (9-cyfrowe, bez jednostek lokalnych) i KRS firm, ktorych pelne dane lub wpis
+ * w rejestrze VAT sa zapamietane, wskazuja na odpowiedzi zapamietane dla ich numeru NIP
+ * (i odwrotnie).
+ */
+typedef struct NIP24Cache NIP24Cache;
+
+/**
+ * Statystyki pamieci podrecznej dla jednej metody API
+ */
+typedef struct NIP24CacheStats {
+	uint64_t Hits;			// odpowiedzi znalezione w pamieci, segmencie wspoldzielonym lub magazynie
+	uint64_t Misses;		// odpowiedzi nieznalezione
+	uint64_t Stale;			// odpowiedzi zwrocone po uplywie waznosci (zawarte w Hits)
+	uint64_t Evictions;		// wazne wpisy usuniete z braku miejsca
+	uint64_t Rejections;	// odpowiedzi niezapamietane, bo wymagalyby usuniecia czesciej uzywanych
+	uint64_t Bytes;			// rozmiar wpisow w pamieci procesu
+	uint64_t Entries;		// liczba wpisow w pamieci procesu
+} NIP24CacheStats;
+
+/////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Utworzenie nowej pamieci podrecznej
+ * @param cache adres na utworzony obiekt
+ * @param max_bytes maksymalny rozmiar przechowywanych odpowiedzi w bajtach
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_new(NIP24Cache** cache, size_t max_bytes);
+
+/**
+ * Dealokacja pamieci podrecznej (nie moze byc uzywana przez zadnego klienta)
+ * @param cache adres na obiekt
+ */
+NIP24_API void nip24_cache_free(NIP24Cache** cache);
+
+/**
+ * Dolaczenie trwalego magazynu odpowiedzi na dysku, zachowywanego miedzy uruchomieniami
+ * aplikacji. Odpowiedzi sa dopisywane do pliku danych, a ich polozenie zapisywane w indeksie
+ * mapowanym do pamieci; brak odpowiedzi w pamieci podrecznej powoduje odczyt pojedynczego
+ * rekordu z magazynu. Ten sam magazyn moze byc jednoczesnie otwarty przez wiele procesow.
+ * Nieaktualne odpowiedzi usuwane sa w tle przez przepisanie plikow.
+ * @param cache obiekt pamieci podrecznej
+ * @param path sciezka i poczatek nazw plikow magazynu (np. C:\dane\nip24 - pliki nip24.ctl,
+ * nip24.N.idx i nip24.N.dat)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu (lub jezeli magazyn zostal juz dolaczony)
+ */
+NIP24_API BOOL nip24_cache_open_store(NIP24Cache* cache, const char* path);
+
+/**
+ * Dolaczenie pamieci podrecznej wspoldzielonej przez wszystkie procesy w sesji, ktore uzywaja
+ * tej samej nazwy. Odpowiedzi przechowywane sa w segmencie pamieci o stalym rozmiarze
+ * (najstarsze sa nadpisywane), a odczyt nie wymaga blokad ani komunikacji miedzy procesami.
+ * Segment istnieje dopoki jest otwarty przez co najmniej jeden proces.
+ * @param cache obiekt pamieci podrecznej
+ * @param name nazwa segmentu (np. nip24)
+ * @param max_bytes rozmiar segmentu w bajtach (jezeli segment juz istnieje, obowiazuje rozmiar
+ * nadany przez proces, ktory go utworzyl)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu (lub jezeli segment zostal juz dolaczony)
+ */
+NIP24_API BOOL nip24_cache_open_shared(NIP24Cache* cache, const char* name, size_t max_bytes);
+
+/**
+ * Zmiana czasu waznosci odpowiedzi metody
+ * @param cache obiekt pamieci podrecznej
+ * @param endpoint metoda API
+ * @param ttl czas waznosci w sekundach (0 - odpowiedzi nie sa zapamietywane)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_set_ttl(NIP24Cache* cache, Endpoint endpoint, int ttl);
+
+/**
+ * Zmiana okresu karencji po uplywie waznosci odpowiedzi. W tym okresie nieaktualna odpowiedz
+ * z pamieci procesu jest zwracana od razu (z ustawionym polem Stale), a jednoczesnie w tle
+ * wysylane jest jedno zapytanie, ktorego wynik zastepuje ja w pamieci podrecznej. Obecnie
+ * dostepne tylko dla metody NIP24_ENDPOINT_INVOICE.
+ * @param cache obiekt pamieci podrecznej
+ * @param endpoint metoda API
+ * @param grace okres karencji w sekundach (0 - nieaktualne odpowiedzi nie sa zwracane)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_set_stale(NIP24Cache* cache, Endpoint endpoint, int grace);
+
+/**
+ * Zmiana czasu waznosci odpowiedzi negatywnych: firma nieaktywna (NIP24_ERR_NIP_NOT_ACTIVE),
+ * nieznana (NIP24_ERR_NIP_UNKNOWN) lub z nieprawidlowym numerem (NIP24_ERR_NIP_BAD). Zapamietany
+ * blad jest zwracany tak jak po odpowiedzi serwisu; metoda nip24_is_active zapamietuje tylko
+ * odpowiedzi negatywne. Domyslnie 1 godzina.
+ * @param cache obiekt pamieci podrecznej
+ * @param ttl czas waznosci w sekundach (0 - odpowiedzi negatywne nie sa zapamietywane)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_set_negative_ttl(NIP24Cache* cache, int ttl);
+
+/**
+ * Zmiana limitu poziomu stalego, w ktorym przechowywane sa odpowiedzi dotyczace minionych dni
+ * (statusy rachunkow, biala lista, wyszukiwanie w rejestrze VAT). Te odpowiedzi nie traca
+ * waznosci i sa usuwane tylko z braku miejsca. Domyslny limit jest rowny max_bytes.
+ * @param cache obiekt pamieci podrecznej
+ * @param max_bytes maksymalny rozmiar w bajtach (0 - odpowiedzi z minionych dni traktowane jak pozostale)
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_set_permanent_limit(NIP24Cache* cache, size_t max_bytes);
+
+/**
+ * Zaladowanie zapisanych wczesniej wynikow sprawdzenia na bialej liscie VAT; kluczem jest NIP,
+ * IBAN i dzien z pola Date (wyniki z minionych dni trafiaja do poziomu stalego)
+ * @param cache obiekt pamieci podrecznej
+ * @param ws tablica wynikow (kopiowanych, pozostaja wlasnoscia wywolujacego)
+ * @param count liczba elementow tablicy
+ * @return liczba zaladowanych wynikow
+ */
+NIP24_API int nip24_cache_preload_whitelist(NIP24Cache* cache, WLStatus* const* ws, int count);
+
+/**
+ * Zaladowanie zapisanych wczesniej wynikow sprawdzenia statusu rachunkow bankowych; kluczem
+ * jest NIP, IBAN i dzien z pola Date (wyniki z minionych dni trafiaja do poziomu stalego)
+ * @param cache obiekt pamieci podrecznej
+ * @param is tablica wynikow (kopiowanych, pozostaja wlasnoscia wywolujacego)
+ * @param count liczba elementow tablicy
+ * @return liczba zaladowanych wynikow
+ */
+NIP24_API int nip24_cache_preload_iban(NIP24Cache* cache, IBANStatus* const* is, int count);
+
+/**
+ * Pobranie statystyk pamieci podrecznej. Gdy pamiec jest pelna, nowa odpowiedz zastepuje
+ * najdawniej uzywany wpis tylko wtedy, gdy pytano o nia czesciej niz o ten wpis; w przeciwnym
+ * razie jest odrzucana (Rejections), co chroni czesto uzywane wpisy przed wyparciem przez
+ * jednorazowe zapytania.
+ * @param cache obiekt pamieci podrecznej
+ * @param endpoint metoda API
+ * @param stats adres na pobrane statystyki
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+NIP24_API BOOL nip24_cache_stats(NIP24Cache* cache, Endpoint endpoint, NIP24CacheStats* stats);
+
+/**
+ * Usuniecie wszystkich wpisow z pamieci (zawartosc magazynu na dysku pozostaje bez zmian)
+ * @param cache obiekt pamieci podrecznej
+ */
+NIP24_API void nip24_cache_clear(NIP24Cache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+/////////////////////////////////////////////////////////////////
+
+#endif
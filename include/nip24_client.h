@@ -34,20 +34,10 @@
 /////////////////////////////////////////////////////////////////
 
 /**
- * Typy numerow identyfikujacych firme
- */
-typedef enum Number {
-	NIP = 1,
-	REGON,
-	KRS,
-	EUVAT,
-    IBAN
-} Number;
-
-/////////////////////////////////////////////////////////////////
-
-/**
- * Klient serwisu NIP24
+ * Klient serwisu NIP24. Jeden obiekt moze byc jednoczesnie uzywany przez wiele watkow
+ * (z zainicjowana biblioteka COM); pola url, id, key, app i cache nie moga byc wtedy
+ * zmieniane. Ostatni blad jest zapamietywany osobno dla kazdego watku (wpis watku jest
+ * zwalniany przez nip24_free, a w watkach roboczych bibliotek - przy ich zakonczeniu).
  */
 typedef struct NIP24Client {
 	char* url;
@@ -56,10 +46,34 @@ typedef struct NIP24Client {
 
 	char* app;
 
-    int err_code;
-	char* err;
+	CRITICAL_SECTION lock;
+	struct NIP24ClientError* errors;
+	DWORD tls;
+
+	NIP24Cache* cache;
 } NIP24Client;
 
+/**
+ * Funkcja informujaca o postepie operacji na wielu firmach (wywolywana z watkow roboczych,
+ * ale nigdy jednoczesnie)
+ * @param ctx dane przekazane przez wywolujacego
+ * @param done liczba zakonczonych zadan
+ * @param total liczba wszystkich zadan
+ * @return TRUE - kontynuacja, FALSE - przerwanie operacji
+ */
+typedef BOOL (*NIP24Progress)(void* ctx, int done, int total);
+
+/**
+ * Funkcja odbierajaca wyniki przetwarzania wsadowego w kolejnosci zadan (wywolywana z watkow
+ * roboczych, ale nigdy jednoczesnie). Funkcja moze przejac obiekt result->Data, ustawiajac
+ * pole na NULL.
+ * @param ctx dane przekazane przez wywolujacego
+ * @param index numer zadania
+ * @param job zadanie
+ * @param result wynik zadania
+ */
+typedef void (*NIP24BatchCallback)(void* ctx, int index, const BatchJob* job, BatchResult* result);
+
 /////////////////////////////////////////////////////////////////
 
 #ifdef __cplusplus
@@ -99,14 +113,15 @@ NIP24_API BOOL nip24_new_test(NIP24Client** nip24);
 NIP24_API void nip24_free(NIP24Client** nip24);
 
 /**
- * Ostatni kod bledu
+ * Ostatni kod bledu zgloszony w biezacym watku
  * @param nip24 adres na obiekt klienta
  * @return kod bledu
  */
 NIP24_API int nip24_get_last_err_code(NIP24Client* nip24);
 
 /**
- * Ostatni komunikat bledu
+ * Ostatni komunikat bledu zgloszony w biezacym watku (wazny do nastepnego wywolania metody
+ * klienta w tym watku)
  * @param nip24 adres na obiekt klienta
  * @return opis bledu lub NULL
  */
@@ -134,7 +149,7 @@ NIP24_API BOOL nip24_is_active_nip(NIP24Client* nip24, const char* nip);
  * @param nip24 adres obiektu klienta
  * @param type typ numeru identyfikujacego firme
  * @param number numer okreslonego typu
- * @param force parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param force TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API InvoiceData* nip24_get_invoice_data(NIP24Client* nip24, Number type, const char* number, BOOL force);
@@ -143,7 +158,7 @@ NIP24_API InvoiceData* nip24_get_invoice_data(NIP24Client* nip24, Number type, c
  * Pobranie podstawowych danych firmy do faktury
  * @param nip24 adres obiektu klienta
  * @param nip numer NIP
- * @param force parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param force TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API InvoiceData* nip24_get_invoice_data_nip(NIP24Client* nip24, const char* nip, BOOL force);
@@ -153,7 +168,7 @@ NIP24_API InvoiceData* nip24_get_invoice_data_nip(NIP24Client* nip24, const char
  * @param nip24 adres obiektu klienta
  * @param type typ numeru identyfikujacego firme
  * @param number numer okreslonego typu
- * @param force parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param force TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API AllData* nip24_get_all_data(NIP24Client* nip24, Number type, const char* number, BOOL force);
@@ -162,7 +177,7 @@ NIP24_API AllData* nip24_get_all_data(NIP24Client* nip24, Number type, const cha
  * Pobranie szczegolowych danych firmy
  * @param nip24 adres obiektu klienta
  * @param nip numer NIP
- * @param force parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param force TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API AllData* nip24_get_all_data_nip(NIP24Client* nip24, const char* nip, BOOL force);
@@ -180,7 +195,7 @@ NIP24_API VIESData* nip24_get_vies_data(NIP24Client* nip24, const char* euvat);
  * @param nip24 adres obiektu klienta
  * @param type typ numeru identyfikujacego firme
  * @param number numer okreslonego typu
- * @param direct parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param direct TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API VATStatus* nip24_get_vat_status(NIP24Client* nip24, Number type, const char* number, BOOL direct);
@@ -189,7 +204,7 @@ NIP24_API VATStatus* nip24_get_vat_status(NIP24Client* nip24, Number type, const
  * Sprawdzenie statusu firmy w rejestrze VAT
  * @param nip24 adres obiektu klienta
  * @param nip numer NIP
- * @param direct parametr ignorowany, zostawiony dla zachowania kompatybilnosci wstecznej
+ * @param direct TRUE - pominiecie odpowiedzi z pamieci podrecznej (parametr nie jest przekazywany do serwisu)
  * @return dane firmy lub NULL w przypadku bledu
  */
 NIP24_API VATStatus* nip24_get_vat_status_nip(NIP24Client* nip24, const char* nip, BOOL direct);
@@ -262,6 +277,59 @@ NIP24_API SearchResult* nip24_search_vat_registry_nip(NIP24Client* nip24, const
  */
 NIP24_API AccountStatus* nip24_get_account_status(NIP24Client* nip24);
 
+/**
+ * Rozgrzanie pamieci podrecznej klienta przed rozpoczeciem pracy. Numery sa normalizowane
+ * (nieprawidlowe pomijane) i usuwane sa powtorzenia. Odpowiedzi dostepne w pamieci podrecznej,
+ * segmencie wspoldzielonym lub magazynie na dysku sa tylko wczytywane, brakujace pobierane
+ * z serwisu rownolegle przez concurrency watkow, nie czesciej niz rate zapytan na sekunde.
+ * @param nip24 adres obiektu klienta (z dolaczona pamiecia podreczna)
+ * @param type typ numerow identyfikujacych firmy
+ * @param numbers tablica numerow
+ * @param count liczba elementow tablicy
+ * @param endpoints metody API: suma wartosci NIP24_ENDPOINT_FLAG (bez NIP24_ENDPOINT_IBAN,
+ * NIP24_ENDPOINT_WHITELIST i NIP24_ENDPOINT_ACTIVE, NIP24_ENDPOINT_VIES tylko dla numerow EUVAT)
+ * @param concurrency liczba watkow roboczych (najwyzej MAXIMUM_WAIT_OBJECTS)
+ * @param rate limit zapytan do serwisu na sekunde (0 - bez limitu)
+ * @param progress funkcja informujaca o postepie lub NULL
+ * @param ctx dane przekazywane do funkcji progress
+ * @return liczba odpowiedzi w pamieci podrecznej lub -1 w przypadku bledu
+ */
+NIP24_API int nip24_cache_prewarm(NIP24Client* nip24, Number type, const char* const* numbers, int count,
+	unsigned int endpoints, int concurrency, int rate, NIP24Progress progress, void* ctx);
+
+/**
+ * Rozgrzanie pamieci podrecznej klienta numerami z pliku tekstowego (jeden numer w wierszu)
+ * @param nip24 adres obiektu klienta (z dolaczona pamiecia podreczna)
+ * @param type typ numerow identyfikujacych firmy
+ * @param path sciezka do pliku
+ * @param endpoints metody API (zob. nip24_cache_prewarm)
+ * @param concurrency liczba watkow roboczych
+ * @param rate limit zapytan do serwisu na sekunde (0 - bez limitu)
+ * @param progress funkcja informujaca o postepie lub NULL
+ * @param ctx dane przekazywane do funkcji progress
+ * @return liczba odpowiedzi w pamieci podrecznej lub -1 w przypadku bledu
+ */
+NIP24_API int nip24_cache_prewarm_file(NIP24Client* nip24, Number type, const char* path, unsigned int endpoints,
+	int concurrency, int rate, NIP24Progress progress, void* ctx);
+
+/**
+ * Wsadowe wykonanie zadan przez concurrency watkow roboczych korzystajacych ze wspolnego obiektu
+ * klienta. Wyniki sa przekazywane do funkcji callback w kolejnosci zadan i/lub zwracane w tablicy
+ * results. Przerwanie przetwarzania przez funkcje progress konczy zadania w toku, pozostale
+ * otrzymuja wynik z kodem NIP24_ERR_CLI_CANCELLED.
+ * @param nip24 adres obiektu klienta
+ * @param jobs tablica zadan
+ * @param count liczba elementow tablicy
+ * @param concurrency liczba watkow roboczych (najwyzej MAXIMUM_WAIT_OBJECTS)
+ * @param results adres na utworzona tablice count wynikow (zob. batchresult_free) lub NULL
+ * @param callback funkcja odbierajaca wyniki lub NULL
+ * @param progress funkcja informujaca o postepie lub NULL
+ * @param ctx dane przekazywane do funkcji callback i progress
+ * @return liczba poprawnie wykonanych zadan lub -1 w przypadku bledu
+ */
+NIP24_API int nip24_batch(NIP24Client* nip24, const BatchJob* jobs, int count, int concurrency,
+	BatchResult** results, NIP24BatchCallback callback, NIP24Progress progress, void* ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -100,6 +100,7 @@
 #define NIP24_ERR_CLI_EXCEPTION           209
 #define NIP24_ERR_CLI_DATEFORMAT          210
 #define NIP24_ERR_CLI_INPUT               211
+#define NIP24_ERR_CLI_CANCELLED           212
 
 /////////////////////////////////////////////////////////////////
 
@@ -24,7 +24,9 @@
 /////////////////////////////////////////////////////////////////
 
 /**
- * Dane firmy wymagane do wystawienia faktury
+ * Dane firmy wymagane do wystawienia faktury (Stale - dane z pamieci podrecznej po uplywie
+ * ich waznosci, zob. nip24_cache_set_stale; Derived - dane wyznaczone z zapamietanych
+ * pelnych danych firmy, zob. nip24_get_all_data)
  */
 typedef struct InvoiceData {
 	char* UID;
@@ -44,6 +46,9 @@ typedef struct InvoiceData {
 	char* Phone;
 	char* Email;
 	char* WWW;
+
+	BOOL Stale;
+	BOOL Derived;
 } InvoiceData;
 
 /////////////////////////////////////////////////////////////////
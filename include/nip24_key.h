@@ -0,0 +1,97 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#ifndef __NIP24_API_KEY_H__
+#define __NIP24_API_KEY_H__
+
+/////////////////////////////////////////////////////////////////
+
+/**
+ * Znormalizowany numer w postaci binarnej (128 bitow), do uzycia jako klucz indeksow
+ * i pamieci podrecznej. Starsze slowo zawiera naglowek: typ numeru (bity 60-63), flage
+ * skrotu (bit 59), kod kraju (bity 48-57) i dlugosc numeru (bity 40-47), pozostale
+ * 104 bity to wartosc numeru.
+ */
+typedef struct NIP24Key {
+	uint64_t hi;
+	uint64_t lo;
+} NIP24Key;
+
+/////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sprawdza poprawnosc numeru i tworzy jego klucz binarny
+ * @param type typ numeru
+ * @param number numer w dowolnym formacie
+ * @param key adres na klucz
+ * @return TRUE jezeli podany numer jest prawidlowy
+ */
+NIP24_API BOOL nip24_key_from_number(Number type, const char* number, NIP24Key* key);
+
+/**
+ * Odtwarza znormalizowany numer z klucza binarnego
+ * @param key klucz
+ * @param out bufor na znormalizowany numer
+ * @param size rozmiar bufora (co najmniej 33 znaki)
+ * @return TRUE jezeli numer zostal odtworzony (FALSE dla kluczy w postaci skrotu)
+ */
+NIP24_API BOOL nip24_key_to_string(const NIP24Key* key, char* out, size_t size);
+
+/**
+ * Typ numeru zapisanego w kluczu
+ * @param key klucz
+ * @return typ numeru
+ */
+NIP24_API Number nip24_key_type(const NIP24Key* key);
+
+/**
+ * Skrot klucza do tablic mieszajacych
+ * @param key klucz
+ * @return skrot klucza
+ */
+NIP24_API uint64_t nip24_key_hash(const NIP24Key* key);
+
+/**
+ * Porownuje dwa klucze (kolejnosc: typ, kraj, dlugosc, wartosc)
+ * @param k1 pierwszy klucz
+ * @param k2 drugi klucz
+ * @return wartosc ujemna, 0 lub dodatnia, jak strcmp
+ */
+NIP24_API int nip24_key_compare(const NIP24Key* k1, const NIP24Key* k2);
+
+/**
+ * Sprawdza czy dwa klucze sa rowne
+ * @param k1 pierwszy klucz
+ * @param k2 drugi klucz
+ * @return TRUE jezeli klucze sa rowne
+ */
+NIP24_API BOOL nip24_key_equals(const NIP24Key* k1, const NIP24Key* k2);
+
+#ifdef __cplusplus
+}
+#endif
+
+/////////////////////////////////////////////////////////////////
+
+#endif
@@ -23,6 +23,26 @@
 
 /////////////////////////////////////////////////////////////////
 
+/**
+ * Typy numerow identyfikujacych firme
+ */
+typedef enum Number {
+	NIP = 1,
+	REGON,
+	KRS,
+	EUVAT,
+    IBAN
+} Number;
+
+/**
+ * Opcje walidacji numerow
+ */
+#define NIP24_VALIDATE_NO_CHECKSUM		0x01	// tylko format, bez cyfr kontrolnych
+#define NIP24_VALIDATE_NO_AMBIGUOUS		0x02	// bez cyfr kontrolnych w krajach z niejednoznacznym algorytmem
+#define NIP24_VALIDATE_NATIONAL			0x04	// krajowe cyfry kontrolne BBAN w numerach IBAN
+
+/////////////////////////////////////////////////////////////////
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,6 +54,15 @@ extern "C" {
  */
 NIP24_API char* nip24_nip_normalize(const char* nip);
 
+/**
+ * Konwertuje podany numer NIP do postaci znormalizowanej bez alokacji pamieci
+ * @param nip numer NIP w dowolnym formacie
+ * @param out bufor na znormalizowany numer NIP
+ * @param size rozmiar bufora (co najmniej 11 znakow)
+ * @return TRUE jezeli numer zostal znormalizowany
+ */
+NIP24_API BOOL nip24_nip_normalize_into(const char* nip, char* out, size_t size);
+
 /**
  * Sprawdza poprawnosc numeru NIP
  * @param nip numer NIP w dowolnym formacie
@@ -48,6 +77,15 @@ NIP24_API BOOL nip24_nip_is_valid(const char* nip);
  */
 NIP24_API char* nip24_regon_normalize(const char* regon);
 
+/**
+ * Konwertuje podany numer REGON do postaci znormalizowanej bez alokacji pamieci
+ * @param regon numer REGON w dowolnym formacie
+ * @param out bufor na znormalizowany numer REGON
+ * @param size rozmiar bufora (co najmniej 15 znakow)
+ * @return TRUE jezeli numer zostal znormalizowany
+ */
+NIP24_API BOOL nip24_regon_normalize_into(const char* regon, char* out, size_t size);
+
 /**
  * Sprawdza poprawnosc numeru REGON
  * @param regon numer REGON w dowolnym formacie
@@ -62,6 +100,15 @@ NIP24_API BOOL nip24_regon_is_valid(const char* regon);
  */
 NIP24_API char* nip24_krs_normalize(const char* krs);
 
+/**
+ * Konwertuje podany numer KRS do postaci znormalizowanej bez alokacji pamieci
+ * @param krs numer KRS w dowolnym formacie
+ * @param out bufor na znormalizowany numer KRS
+ * @param size rozmiar bufora (co najmniej 11 znakow)
+ * @return TRUE jezeli numer zostal znormalizowany
+ */
+NIP24_API BOOL nip24_krs_normalize_into(const char* krs, char* out, size_t size);
+
 /**
  * Sprawdza poprawnosc numeru KRS
  * @param krs numer KRS w dowolnym formacie
@@ -76,6 +123,15 @@ NIP24_API BOOL nip24_krs_is_valid(const char* krs);
  */
 NIP24_API char* nip24_euvat_normalize(const char* euvat);
 
+/**
+ * Konwertuje podany numer EU VAT ID do postaci znormalizowanej bez alokacji pamieci
+ * @param euvat numer EU VAT ID w dowolnym formacie
+ * @param out bufor na znormalizowany numer EU VAT ID
+ * @param size rozmiar bufora (co najmniej 15 znakow)
+ * @return TRUE jezeli numer zostal znormalizowany
+ */
+NIP24_API BOOL nip24_euvat_normalize_into(const char* euvat, char* out, size_t size);
+
 /**
  * Sprawdza poprawnosc numeru EU VAT ID
  * @param euvat numer EU VAT ID w dowolnym formacie
@@ -83,6 +139,15 @@ NIP24_API char* nip24_euvat_normalize(const char* euvat);
  */
 NIP24_API BOOL nip24_euvat_is_valid(const char* euvat);
 
+/**
+ * Sprawdza poprawnosc numeru EU VAT ID z okreslonymi opcjami. Domyslnie (flags = 0)
+ * sprawdzane sa format i cyfry kontrolne wg algorytmu danego kraju.
+ * @param euvat numer EU VAT ID w dowolnym formacie
+ * @param flags opcje walidacji (NIP24_VALIDATE_*)
+ * @return TRUE jezeli podany numer jest prawidlowy
+ */
+NIP24_API BOOL nip24_euvat_is_valid_ex(const char* euvat, int flags);
+
 /**
  * Konwertuje podany numer IBAN do postaci znormalizowanej
  * @param euvat numer IBAN w dowolnym formacie
@@ -90,6 +155,15 @@ NIP24_API BOOL nip24_euvat_is_valid(const char* euvat);
  */
 NIP24_API char* nip24_iban_normalize(const char* iban);
 
+/**
+ * Konwertuje podany numer IBAN do postaci znormalizowanej bez alokacji pamieci
+ * @param iban numer IBAN w dowolnym formacie
+ * @param out bufor na znormalizowany numer IBAN
+ * @param size rozmiar bufora (co najmniej 33 znakow)
+ * @return TRUE jezeli numer zostal znormalizowany
+ */
+NIP24_API BOOL nip24_iban_normalize_into(const char* iban, char* out, size_t size);
+
 /**
  * Sprawdza poprawnosc numeru IBAN
  * @param euvat numer IBAN w dowolnym formacie
@@ -97,6 +171,66 @@ NIP24_API char* nip24_iban_normalize(const char* iban);
  */
 NIP24_API BOOL nip24_iban_is_valid(const char* iban);
 
+/**
+ * Sprawdza poprawnosc numeru IBAN z okreslonymi opcjami. Z opcja NIP24_VALIDATE_NATIONAL
+ * sprawdzane sa takze krajowe cyfry kontrolne BBAN (BA, BE, EE, ES, FI, FR, IT, MC, ME, MK,
+ * NO, PL, PT, RS, SI, SM).
+ * @param iban numer IBAN w dowolnym formacie
+ * @param flags opcje walidacji (NIP24_VALIDATE_*)
+ * @return TRUE jezeli podany numer jest prawidlowy
+ */
+NIP24_API BOOL nip24_iban_is_valid_ex(const char* iban, int flags);
+
+/**
+ * Sprawdza poprawnosc numeru okreslonego typu i jednoczesnie konwertuje go do postaci
+ * znormalizowanej (jeden przebieg po numerze wejsciowym, bez alokacji pamieci)
+ * @param type typ numeru
+ * @param number numer w dowolnym formacie
+ * @param out bufor na znormalizowany numer
+ * @param size rozmiar bufora (co najmniej 33 znaki)
+ * @return TRUE jezeli podany numer jest prawidlowy
+ */
+NIP24_API BOOL nip24_number_check(Number type, const char* number, char* out, size_t size);
+
+/**
+ * Rozpoznaje typ numeru na podstawie klas znakow, dlugosci i sum kontrolnych
+ * @param number numer w dowolnym formacie
+ * @param candidates tablica na typy pasujace do numeru, od najbardziej prawdopodobnego
+ * (typy potwierdzone suma kontrolna przed KRS, ktory nie ma sumy kontrolnej; numer IBAN
+ * jest rozpoznawany tylko z kodem kraju)
+ * @param size rozmiar tablicy candidates
+ * @return liczba rozpoznanych typow (0 jezeli numer nie pasuje do zadnego typu)
+ */
+NIP24_API int nip24_detect_number_type(const char* number, Number* candidates, int size);
+
+/**
+ * Sprawdza poprawnosc tablicy numerow NIP (sumy kontrolne liczone blokami, z AVX2 jezeli
+ * procesor go obsluguje)
+ * @param nip tablica numerow NIP w dowolnym formacie
+ * @param n liczba numerow
+ * @param ok tablica n wynikow: 1 jezeli numer jest prawidlowy, 0 w przeciwnym razie
+ * @return liczba prawidlowych numerow
+ */
+NIP24_API size_t nip24_nip_validate_batch(const char* const* nip, size_t n, uint8_t* ok);
+
+/**
+ * Sprawdza poprawnosc tablicy numerow REGON (9 lub 14 cyfr)
+ * @param regon tablica numerow REGON w dowolnym formacie
+ * @param n liczba numerow
+ * @param ok tablica n wynikow: 1 jezeli numer jest prawidlowy, 0 w przeciwnym razie
+ * @return liczba prawidlowych numerow
+ */
+NIP24_API size_t nip24_regon_validate_batch(const char* const* regon, size_t n, uint8_t* ok);
+
+/**
+ * Sprawdza poprawnosc tablicy numerow IBAN
+ * @param iban tablica numerow IBAN w dowolnym formacie
+ * @param n liczba numerow
+ * @param ok tablica n wynikow: 1 jezeli numer jest prawidlowy, 0 w przeciwnym razie
+ * @return liczba prawidlowych numerow
+ */
+NIP24_API size_t nip24_iban_validate_batch(const char* const* iban, size_t n, uint8_t* ok);
+
 #ifdef __cplusplus
 }
 #endif
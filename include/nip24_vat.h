@@ -30,7 +30,8 @@
 /////////////////////////////////////////////////////////////////
 
 /**
- * Status firmy w rejestrze VAT
+ * Status firmy w rejestrze VAT (Derived - status wyznaczony z zapamietanego dzisiejszego
+ * wyniku wyszukiwania w rejestrze VAT, zob. nip24_search_vat_registry)
  */
 typedef struct VATStatus {
 	char* UID;
@@ -45,6 +46,8 @@ typedef struct VATStatus {
 	char* ID;
 	time_t Date;
 	char* Source;
+
+	BOOL Derived;
 } VATStatus;
 
 /////////////////////////////////////////////////////////////////
@@ -24,7 +24,8 @@
 /////////////////////////////////////////////////////////////////
 
 /**
- * Status podmiotu na biaej licie
+ * Status podmiotu na biaej licie (Derived - status wyznaczony z zapamietanego wyniku
+ * wyszukiwania w rejestrze VAT dla tego samego dnia, zob. nip24_search_vat_registry)
  */
 typedef struct WLStatus {
 	char* UID;
@@ -42,6 +43,8 @@ typedef struct WLStatus {
 	int MaskIndex;
 	time_t Date;
 	char* Source;
+
+	BOOL Derived;
 } WLStatus;
 
 /////////////////////////////////////////////////////////////////
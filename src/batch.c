@@ -0,0 +1,290 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define BATCH_THREADS		MAXIMUM_WAIT_OBJECTS
+
+/**
+ * Wspolny stan przetwarzania wsadowego. Wyniki zadan zakonczonych poza kolejnoscia czekaja
+ * w tablicy results, az zostana przekazane wszystkie wczesniejsze.
+ */
+typedef struct Batch {
+	NIP24Client* nip24;
+
+	const BatchJob* jobs;
+	BatchResult* results;
+	BYTE* finished;
+	int count;
+
+	volatile LONG next;
+
+	CRITICAL_SECTION lock;
+
+	int delivered;
+	BOOL keep;
+
+	int done;
+	int ok;
+	volatile BOOL cancel;
+
+	NIP24BatchCallback callback;
+	NIP24Progress progress;
+	void* ctx;
+} Batch;
+
+/////////////////////////////////////////////////////////////////
+
+static void _nip24_batch_clear(BatchResult* result)
+{
+	void* obj = result->Data;
+
+	if (obj) {
+		if (result->Method == NIP24_ENDPOINT_INVOICE) {
+			invoicedata_free((InvoiceData**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_ALL) {
+			alldata_free((AllData**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_VIES) {
+			viesdata_free((VIESData**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_VAT) {
+			vatstatus_free((VATStatus**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_IBAN) {
+			ibanstatus_free((IBANStatus**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_WHITELIST) {
+			wlstatus_free((WLStatus**)&obj);
+		}
+		else if (result->Method == NIP24_ENDPOINT_SEARCH) {
+			searchresult_free((SearchResult**)&obj);
+		}
+	}
+
+	free(result->Err);
+
+	memset(result, 0, sizeof(BatchResult));
+}
+
+/**
+ * Wykonanie jednego zadania (blad jest odczytywany z biezacego watku klienta)
+ */
+static void _nip24_batch_one(NIP24Client* nip24, const BatchJob* job, BatchResult* result)
+{
+	const char* err;
+
+	result->Method = job->Method;
+
+	if (job->Method == NIP24_ENDPOINT_INVOICE) {
+		result->Data = nip24_get_invoice_data(nip24, job->Type, job->Value, job->Force);
+	}
+	else if (job->Method == NIP24_ENDPOINT_ALL) {
+		result->Data = nip24_get_all_data(nip24, job->Type, job->Value, job->Force);
+	}
+	else if (job->Method == NIP24_ENDPOINT_VIES) {
+		result->Data = nip24_get_vies_data(nip24, job->Value);
+	}
+	else if (job->Method == NIP24_ENDPOINT_VAT) {
+		result->Data = nip24_get_vat_status(nip24, job->Type, job->Value, job->Force);
+	}
+	else if (job->Method == NIP24_ENDPOINT_IBAN) {
+		result->Data = nip24_get_iban_status(nip24, job->Type, job->Value, job->IBAN, job->Date);
+	}
+	else if (job->Method == NIP24_ENDPOINT_WHITELIST) {
+		result->Data = nip24_get_whitelist_status(nip24, job->Type, job->Value, job->IBAN, job->Date);
+	}
+	else if (job->Method == NIP24_ENDPOINT_SEARCH) {
+		result->Data = nip24_search_vat_registry(nip24, job->Type, job->Value, job->Date);
+	}
+	else if (job->Method == NIP24_ENDPOINT_ACTIVE) {
+		result->Active = nip24_is_active(nip24, job->Type, job->Value);
+	}
+	else {
+		result->ErrCode = NIP24_ERR_CLI_INPUT;
+		result->Err = strdup(nip24_errstr(NIP24_ERR_CLI_INPUT));
+		return;
+	}
+
+	if ((result->ErrCode = nip24_get_last_err_code(nip24)) != 0) {
+		err = nip24_get_last_err(nip24);
+		result->Err = strdup(err ? err : "");
+	}
+}
+
+/**
+ * Przekazanie do funkcji callback zakonczonych wynikow w kolejnosci zadan (wywolywane pod blokada)
+ */
+static void _nip24_batch_deliver(Batch* b)
+{
+	while (b->delivered < b->count && b->finished[b->delivered]) {
+		if (b->callback) {
+			b->callback(b->ctx, b->delivered, &b->jobs[b->delivered], &b->results[b->delivered]);
+		}
+
+		if (!b->keep) {
+			_nip24_batch_clear(&b->results[b->delivered]);
+		}
+
+		b->delivered++;
+	}
+}
+
+static DWORD WINAPI _nip24_batch_proc(LPVOID param)
+{
+	Batch* b = (Batch*)param;
+
+	LONG j;
+
+	CoInitialize(NULL);
+
+	while (!b->cancel && (j = InterlockedIncrement(&b->next) - 1) < b->count) {
+		_nip24_batch_one(b->nip24, &b->jobs[j], &b->results[j]);
+
+		EnterCriticalSection(&b->lock);
+
+		b->finished[j] = TRUE;
+		b->done++;
+
+		if (b->results[j].ErrCode == 0) {
+			b->ok++;
+		}
+
+		_nip24_batch_deliver(b);
+
+		if (b->progress && !b->cancel && !b->progress(b->ctx, b->done, b->count)) {
+			b->cancel = TRUE;
+		}
+
+		LeaveCriticalSection(&b->lock);
+	}
+
+	client_release_err(b->nip24);
+
+	CoUninitialize();
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////
+
+NIP24_API int nip24_batch(NIP24Client* nip24, const BatchJob* jobs, int count, int concurrency,
+	BatchResult** results, NIP24BatchCallback callback, NIP24Progress progress, void* ctx)
+{
+	HANDLE threads[BATCH_THREADS];
+	Batch b;
+
+	int threads_count = 0;
+	int ret = -1;
+	int i;
+
+	memset(&b, 0, sizeof(b));
+
+	if (!nip24 || (!jobs && count > 0) || count < 0 || concurrency < 1) {
+		return -1;
+	}
+
+	InitializeCriticalSection(&b.lock);
+
+	if ((b.results = (BatchResult*)calloc(count + 1, sizeof(BatchResult))) == NULL) {
+		goto err;
+	}
+
+	if ((b.finished = (BYTE*)calloc(count + 1, sizeof(BYTE))) == NULL) {
+		goto err;
+	}
+
+	b.nip24 = nip24;
+	b.jobs = jobs;
+	b.count = count;
+	b.keep = (results != NULL);
+	b.callback = callback;
+	b.progress = progress;
+	b.ctx = ctx;
+
+	// watki robocze
+	for (i = 0; i < concurrency && i < BATCH_THREADS && i < count; i++) {
+		if ((threads[threads_count] = CreateThread(NULL, 0, _nip24_batch_proc, &b, 0, NULL)) == NULL) {
+			break;
+		}
+
+		threads_count++;
+	}
+
+	if (threads_count == 0 && count > 0) {
+		goto err;
+	}
+
+	if (threads_count > 0) {
+		WaitForMultipleObjects(threads_count, threads, TRUE, INFINITE);
+	}
+
+	for (i = 0; i < threads_count; i++) {
+		CloseHandle(threads[i]);
+	}
+
+	// zadania pominiete po przerwaniu
+	for (i = 0; i < count; i++) {
+		if (!b.finished[i]) {
+			b.results[i].Method = jobs[i].Method;
+			b.results[i].ErrCode = NIP24_ERR_CLI_CANCELLED;
+			b.results[i].Err = strdup(nip24_errstr(NIP24_ERR_CLI_CANCELLED));
+
+			b.finished[i] = TRUE;
+		}
+	}
+
+	_nip24_batch_deliver(&b);
+
+	// ok
+	if (results) {
+		*results = b.results;
+		b.results = NULL;
+	}
+
+	ret = b.ok;
+
+err:
+	batchresult_free(&b.results, count);
+	free(b.finished);
+
+	DeleteCriticalSection(&b.lock);
+
+	return ret;
+}
+
+NIP24_API void batchresult_free(BatchResult** results, int count)
+{
+	BatchResult* r = (results ? *results : NULL);
+
+	int i;
+
+	if (r) {
+		for (i = 0; i < count; i++) {
+			_nip24_batch_clear(&r[i]);
+		}
+
+		free(*results);
+		*results = NULL;
+	}
+}
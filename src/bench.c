@@ -0,0 +1,842 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+
+#include "internal.h"
+#include "nip24.h"
+
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
+
+#define ITERATIONS		1000000
+#define DECODES			20000
+#define DATASET			10000
+#define ROWS			1000000
+
+/////////////////////////////////////////////////////////////////
+
+// Przykladowe numery EU VAT ID dla kazdego kraju
+static const char* euvat[] = {
+	"ATU13585627",
+	"BE0403019261",
+	"BG175074752",
+	"CY10259033P",
+	"CZ25123891",
+	"DE136695976",
+	"DK13585628",
+	"EE100931558",
+	"EL094259216",
+	"ESB58378431",
+	"FI20774740",
+	"FR40303265045",
+	"HR33392005961",
+	"HU12892312",
+	"IE6433435F",
+	"IT00743110157",
+	"LT119511515",
+	"LU15027442",
+	"LV40003521600",
+	"MT11679112",
+	"NL004495445B01",
+	"PL7171642051",
+	"PT501964843",
+	"RO18547290",
+	"SE123456789701",
+	"SI50223054",
+	"SK2022749619",
+	"XI980780684"
+};
+
+// Zapisane odpowiedzi serwera dla kazdej metody API
+static const char* xml_invoice =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<firm><uid>a8c9f3e1b2d04f6e9a7c5b3d1e0f2a4c</uid><nip>7171642051</nip>"
+	"<name>NETCAT Sp. z o.o.</name><firstname></firstname><lastname></lastname>"
+	"<street>Sienkiewicza</street><streetNumber>24</streetNumber><houseNumber>3</houseNumber>"
+	"<city>Lublin</city><postCode>20-002</postCode><postCity>Lublin</postCity>"
+	"<phone>+48 81 532 47 68</phone><email>firma@netcat.pl</email><www>www.netcat.pl</www>"
+	"</firm></result>";
+
+static const char* xml_all =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<firm><uid>b1d2e3f4a5b6c7d8e9f0a1b2c3d4e5f6</uid><type>P</type><nip>7171642051</nip><regon>060401460</regon>"
+	"<name>NETCAT Sp. z o.o.</name><shortname>NETCAT</shortname><firstname></firstname>"
+	"<secondname></secondname><lastname></lastname>"
+	"<street>ul. Sienkiewicza</street><streetCode>19612</streetCode><streetNumber>24</streetNumber>"
+	"<houseNumber>3</houseNumber><city>Lublin</city><cityCode>0954877</cityCode>"
+	"<community>Lublin</community><communityCode>066301</communityCode><county>Lublin</county>"
+	"<countyCode>0663</countyCode><state>lubelskie</state><stateCode>06</stateCode>"
+	"<postCode>20-002</postCode><postCity>Lublin</postCity>"
+	"<phone>815324768</phone><email>firma@netcat.pl</email><www>www.netcat.pl</www>"
+	"<creationDate>1997-03-14T00:00:00</creationDate><startDate>1997-03-14T00:00:00</startDate>"
+	"<registrationDate>1997-03-14T00:00:00</registrationDate><holdDate></holdDate><renevalDate></renevalDate>"
+	"<lastUpdateDate>2024-11-05T00:00:00</lastUpdateDate><bankruptcyDate></bankruptcyDate>"
+	"<endOfBankruptcyProceedingsDate></endOfBankruptcyProceedingsDate><endDate></endDate>"
+	"<registryEntity><code>138</code><name>SAD REJONOWY LUBLIN-WSCHOD</name></registryEntity>"
+	"<registry><code>138</code><name>REJESTR PRZEDSIEBIORCOW</name></registry>"
+	"<record><created>2001-08-01T00:00:00</created><number>0000030896</number></record>"
+	"<basicLegalForm><code>2</code><name>JEDNOSTKA ORGANIZACYJNA NIEMAJACA OSOBOWOSCI PRAWNEJ</name></basicLegalForm>"
+	"<specificLegalForm><code>117</code><name>SPOLKI Z OGRANICZONA ODPOWIEDZIALNOSCIA</name></specificLegalForm>"
+	"<ownershipForm><code>214</code><name>WLASNOSC KRAJOWYCH OSOB FIZYCZNYCH</name></ownershipForm>"
+	"<businessPartners>"
+	"<businessPartner><regon>060401460</regon><firmName></firmName><firstName>JAN</firstName>"
+	"<secondName></secondName><lastName>KOWALSKI</lastName></businessPartner>"
+	"<businessPartner><regon>060401460</regon><firmName></firmName><firstName>ANNA</firstName>"
+	"<secondName>MARIA</secondName><lastName>NOWAK</lastName></businessPartner>"
+	"</businessPartners>"
+	"<PKDs>"
+	"<PKD><code>6201Z</code><description>DZIALALNOSC ZWIAZANA Z OPROGRAMOWANIEM</description>"
+	"<primary>true</primary><version>2007</version></PKD>"
+	"<PKD><code>6202Z</code><description>DZIALALNOSC ZWIAZANA Z DORADZTWEM W ZAKRESIE INFORMATYKI</description>"
+	"<primary>false</primary><version>2007</version></PKD>"
+	"<PKD><code>6311Z</code><description>PRZETWARZANIE DANYCH; ZARZADZANIE STRONAMI INTERNETOWYMI (HOSTING)</description>"
+	"<primary>false</primary><version>2007</version></PKD>"
+	"</PKDs>"
+	"</firm></result>";
+
+static const char* xml_vies =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<vies><uid>c3d4e5f6a7b8c9d0e1f2a3b4c5d6e7f8</uid><countryCode>PL</countryCode>"
+	"<vatNumber>7171642051</vatNumber><valid>true</valid><traderName>NETCAT SP. Z O.O.</traderName>"
+	"<traderCompanyType>---</traderCompanyType><traderAddress>SIENKIEWICZA 24/3, 20-002 LUBLIN</traderAddress>"
+	"<id>5f3a9c2e71d84b06</id><date>2025-01-15+01:00</date><source>http://ec.europa.eu</source>"
+	"</vies></result>";
+
+static const char* xml_vat =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<vat><uid>d4e5f6a7b8c9d0e1f2a3b4c5d6e7f8a9</uid><nip>7171642051</nip><regon>060401460</regon>"
+	"<name>NETCAT SPOLKA Z OGRANICZONA ODPOWIEDZIALNOSCIA</name><status>1</status>"
+	"<result>Podmiot o podanym identyfikatorze podatkowym NIP jest zarejestrowany jako podatnik VAT czynny</result>"
+	"<id>W2A1-7C3K-9DXR</id><date>2025-01-15+01:00</date><source>http://www.mf.gov.pl</source>"
+	"</vat></result>";
+
+static const char* xml_iban =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<iban><uid>e5f6a7b8c9d0e1f2a3b4c5d6e7f8a9b0</uid><nip>7171642051</nip><regon>060401460</regon>"
+	"<iban>PL61109010140000071219812874</iban><valid>true</valid>"
+	"<id>a7d9f1c3-5e2b-4d80-9b6a-0c4e8f2d1a3b</id><date>2025-01-15+01:00</date>"
+	"<source>https://wl-api.mf.gov.pl</source>"
+	"</iban></result>";
+
+static const char* xml_whitelist =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<whitelist><uid>f6a7b8c9d0e1f2a3b4c5d6e7f8a9b0c1</uid><nip>7171642051</nip>"
+	"<iban>PL61109010140000071219812874</iban><valid>true</valid><virtual>false</virtual>"
+	"<vatStatus>1</vatStatus><vatResult>Czynny</vatResult><hashIndex>0</hashIndex><maskIndex>-1</maskIndex>"
+	"<date>2025-01-15+01:00</date><source>https://plikplaski.mf.gov.pl</source>"
+	"</whitelist></result>";
+
+static const char* xml_search =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<search><uid>a7b8c9d0e1f2a3b4c5d6e7f8a9b0c1d2</uid><entities>"
+	"<entity><name>NETCAT SPOLKA Z OGRANICZONA ODPOWIEDZIALNOSCIA</name><nip>7171642051</nip>"
+	"<regon>060401460</regon><krs>0000030896</krs>"
+	"<residenceAddress>SIENKIEWICZA 24/3, 20-002 LUBLIN</residenceAddress><workingAddress></workingAddress>"
+	"<vat><status>1</status><result>Czynny</result></vat>"
+	"<representatives><person><nip></nip><companyName></companyName><firstName>JAN</firstName>"
+	"<lastName>KOWALSKI</lastName></person></representatives>"
+	"<authorizedClerks></authorizedClerks>"
+	"<partners><person><nip>7171642051</nip><companyName>NETCAT</companyName><firstName></firstName>"
+	"<lastName></lastName></person></partners>"
+	"<ibans><iban>61109010140000071219812874</iban><iban>27114020040000350271063850</iban></ibans>"
+	"<hasVirtualAccounts>false</hasVirtualAccounts>"
+	"<registrationLegalDate>2001-08-01+02:00</registrationLegalDate><registrationDenialDate></registrationDenialDate>"
+	"<registrationDenialBasis></registrationDenialBasis><restorationDate></restorationDate>"
+	"<restorationBasis></restorationBasis><removalDate></removalDate><removalBasis></removalBasis>"
+	"</entity>"
+	"</entities><id>Yp2W-8Kx4-QmZ1</id><date>2025-01-15+01:00</date><source>https://wl-api.mf.gov.pl</source>"
+	"</search></result>";
+
+static const char* xml_account =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?><result>"
+	"<account><uid>b8c9d0e1f2a3b4c5d6e7f8a9b0c1d2e3</uid><type>Business</type>"
+	"<validTo>2025-12-31T23:59:59</validTo>"
+	"<billingPlan><name>Biznes</name><subscriptionPrice>99.00</subscriptionPrice><itemPrice>0.05</itemPrice>"
+	"<itemPriceCheckStatus>0.01</itemPriceCheckStatus><itemPriceInvoiceData>0.02</itemPriceInvoiceData>"
+	"<itemPriceAllData>0.05</itemPriceAllData><itemPriceAllIBAN>0.01</itemPriceAllIBAN>"
+	"<itemPriceWLStatus>0.01</itemPriceWLStatus><itemPriceSearchVAT>0.02</itemPriceSearchVAT>"
+	"<limit>10000</limit><requestDelay>0</requestDelay><domainLimit>5</domainLimit>"
+	"<overplanAllowed>true</overplanAllowed><terytCodes>true</terytCodes><excelAddin>true</excelAddin>"
+	"<jpkVat>true</jpkVat><cli>true</cli><stats>true</stats><nipMonitor>false</nipMonitor>"
+	"<searchByNip>true</searchByNip><searchByRegon>true</searchByRegon><searchByKrs>true</searchByKrs>"
+	"<funcIsActive>true</funcIsActive><funcGetInvoiceData>true</funcGetInvoiceData>"
+	"<funcGetAllData>true</funcGetAllData><funcGetVIESData>true</funcGetVIESData>"
+	"<funcGetVATStatus>true</funcGetVATStatus><funcGetIBANStatus>true</funcGetIBANStatus>"
+	"<funcGetWLStatus>true</funcGetWLStatus><funcSearchVAT>true</funcSearchVAT></billingPlan>"
+	"<requests><invoiceData>120</invoiceData><allData>45</allData><firmStatus>300</firmStatus>"
+	"<vatStatus>210</vatStatus><viesStatus>18</viesStatus><ibanStatus>77</ibanStatus>"
+	"<wlStatus>64</wlStatus><searchVAT>9</searchVAT><total>843</total></requests>"
+	"</account></result>";
+
+// Wagi sum kontrolnych
+static const int wnip[] = {
+	6, 5, 7, 2, 3, 4, 5, 6, 7
+};
+
+static const int w9[] = {
+	8, 9, 2, 3, 4, 5, 6, 7
+};
+
+static const int w14[] = {
+	2, 4, 8, 5, 0, 9, 7, 3, 6, 1, 2, 4, 8
+};
+
+/////////////////////////////////////////////////////////////////
+
+#define DECODER(name, type, decode, release) \
+	static BOOL name(IXMLDOMDocument2* doc) \
+	{ \
+		type* obj = decode(doc); \
+		BOOL ok = (obj != NULL); \
+		release(&obj); \
+		return ok; \
+	}
+
+DECODER(bench_decode_invoice, InvoiceData, decode_invoice_data, invoicedata_free)
+DECODER(bench_decode_all, AllData, decode_all_data, alldata_free)
+DECODER(bench_decode_vies, VIESData, decode_vies_data, viesdata_free)
+DECODER(bench_decode_vat, VATStatus, decode_vat_status, vatstatus_free)
+DECODER(bench_decode_iban, IBANStatus, decode_iban_status, ibanstatus_free)
+DECODER(bench_decode_whitelist, WLStatus, decode_whitelist_status, wlstatus_free)
+DECODER(bench_decode_search, SearchResult, decode_search_result, searchresult_free)
+DECODER(bench_decode_account, AccountStatus, decode_account_status, accountstatus_free)
+
+typedef struct Response {
+	const char* name;
+	const char** xml;
+	BOOL (*decode)(IXMLDOMDocument2* doc);
+} Response;
+
+static const Response responses[] = {
+	{ "invoice", &xml_invoice, bench_decode_invoice },
+	{ "all", &xml_all, bench_decode_all },
+	{ "vies", &xml_vies, bench_decode_vies },
+	{ "vat", &xml_vat, bench_decode_vat },
+	{ "iban", &xml_iban, bench_decode_iban },
+	{ "whitelist", &xml_whitelist, bench_decode_whitelist },
+	{ "search", &xml_search, bench_decode_search },
+	{ "account", &xml_account, bench_decode_account }
+};
+
+/////////////////////////////////////////////////////////////////
+
+static BOOL machine = FALSE;
+static const char* filter = NULL;
+static uint64_t seed = 1;
+
+#ifdef _DEBUG
+static volatile long allocs;
+
+/**
+ * Zliczanie alokacji sterty CRT (tylko w wersji Debug)
+ */
+static int alloc_hook(int type, void* data, size_t size, int block, long request,
+	const unsigned char* file, int line)
+{
+	if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) {
+		allocs++;
+	}
+
+	return TRUE;
+}
+#endif
+
+static double now()
+{
+	static LARGE_INTEGER freq;
+
+	LARGE_INTEGER cnt;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+
+	QueryPerformanceCounter(&cnt);
+
+	return (double)cnt.QuadPart / (double)freq.QuadPart;
+}
+
+static long alloc_count()
+{
+#ifdef _DEBUG
+	return allocs;
+#else
+	return 0;
+#endif
+}
+
+static BOOL selected(const char* name)
+{
+	return (!filter || strstr(name, filter) ? TRUE : FALSE);
+}
+
+/**
+ * Wydruk wyniku pomiaru
+ * @param name nazwa pomiaru
+ * @param ops liczba operacji
+ * @param bytes liczba przetworzonych bajtow danych wejsciowych
+ * @param secs czas w sekundach
+ * @param alloc liczba alokacji
+ * @param ok TRUE jezeli wyniki zgodne z oczekiwanymi
+ */
+static void report(const char* name, size_t ops, size_t bytes, double secs, long alloc, BOOL ok)
+{
+	double ns = secs * 1e9 / ops;
+	double mbs = bytes / secs / (1024.0 * 1024.0);
+
+	if (machine) {
+#ifdef _DEBUG
+		printf("%s\t%zu\t%.2f\t%.3f\t%.2f\t%s\n", name, ops, ns, (double)alloc / ops, mbs, (ok ? "OK" : "BLAD"));
+#else
+		printf("%s\t%zu\t%.2f\t-\t%.2f\t%s\n", name, ops, ns, mbs, (ok ? "OK" : "BLAD"));
+#endif
+	}
+	else {
+#ifdef _DEBUG
+		printf("%-22s %10.1f ns/op %8.2f alloc/op %10.1f MB/s  %s\n", name, ns, (double)alloc / ops, mbs,
+			(ok ? "OK" : "BLAD"));
+#else
+		printf("%-22s %10.1f ns/op %8s alloc/op %10.1f MB/s  %s\n", name, ns, "-", mbs,
+			(ok ? "OK" : "BLAD"));
+#endif
+	}
+}
+
+static void report_err(const char* name)
+{
+	if (machine) {
+		printf("%s\t0\t-\t-\t-\tBLAD\n", name);
+	}
+	else {
+		printf("%-22s %10s ns/op %8s alloc/op %10s MB/s  BLAD\n", name, "-", "-", "-");
+	}
+}
+
+/////////////////////////////////////////////////////////////////
+
+/**
+ * Generator pseudolosowy xorshift64*, niezalezny od implementacji rand() w CRT,
+ * aby zestawy danych byly identyczne miedzy kompilacjami
+ */
+static uint32_t next()
+{
+	seed ^= seed >> 12;
+	seed ^= seed << 25;
+	seed ^= seed >> 27;
+
+	return (uint32_t)((seed * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static char** dataset_new()
+{
+	return (char**)calloc(DATASET, sizeof(char*));
+}
+
+static void dataset_free(char*** rows)
+{
+	int i;
+
+	if (!*rows) {
+		return;
+	}
+
+	for (i = 0; i < DATASET; i++) {
+		free((*rows)[i]);
+	}
+
+	free(*rows);
+	*rows = NULL;
+}
+
+/**
+ * Numer z suma kontrolna modulo 11 wg wag w
+ * @param len dlugosc numeru
+ * @param w wagi
+ * @param valid TRUE - poprawna suma kontrolna, FALSE - celowo bledna
+ */
+static char* gen_number(int len, const int* w, BOOL valid)
+{
+	char* num = (char*)malloc(len + 1);
+
+	int sum;
+	int i;
+
+	do {
+		for (i = 0, sum = 0; i < len - 1; i++) {
+			num[i] = '0' + next() % 10;
+			sum += (num[i] - '0') * w[i];
+		}
+	} while (len == 10 && sum % 11 == 10);
+
+	num[len - 1] = '0' + (sum % 11) % 10;
+
+	if (!valid) {
+		num[len - 1] = '0' + (num[len - 1] - '0' + 1 + next() % 9) % 10;
+	}
+
+	num[len] = '\0';
+
+	return num;
+}
+
+/**
+ * REGON 14-cyfrowy: poprawny REGON 9-cyfrowy, numer jednostki lokalnej i druga suma kontrolna
+ */
+static char* gen_regon14(BOOL valid)
+{
+	char* num = (char*)malloc(15);
+	char* regon = gen_number(9, w9, TRUE);
+
+	int sum = 0;
+	int i;
+
+	memcpy(num, regon, 9);
+	free(regon);
+
+	for (i = 9; i < 13; i++) {
+		num[i] = '0' + next() % 10;
+	}
+
+	for (i = 0; i < 13; i++) {
+		sum += (num[i] - '0') * w14[i];
+	}
+
+	num[13] = '0' + (sum % 11) % 10;
+
+	if (!valid) {
+		num[13] = '0' + (num[13] - '0' + 1 + next() % 9) % 10;
+	}
+
+	num[14] = '\0';
+
+	return num;
+}
+
+static char* gen_krs(BOOL valid)
+{
+	char* num = (char*)malloc(12);
+
+	int len = (valid ? 1 + next() % 10 : 11);
+	int i;
+
+	for (i = 0; i < len; i++) {
+		num[i] = '0' + next() % 10;
+	}
+
+	// 11 cyfr bez zer wiodacych, aby numer nie miescil sie w 10 cyfrach
+	if (!valid) {
+		num[0] = '1' + next() % 9;
+	}
+
+	num[len] = '\0';
+
+	return num;
+}
+
+/**
+ * IBAN wg formatu kraju z tabeli walidatora, z poprawnymi
+ * lub celowo blednymi cyframi kontrolnymi
+ */
+static char* gen_iban(const char* country, BOOL valid)
+{
+	static const char* digits = "0123456789";
+	static const char* alpha = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static const char* alnum = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+	const FormatRun* run;
+	char* num;
+
+	uint64_t chk = 0;
+
+	int len;
+	int p;
+	int i;
+	int k;
+
+	if ((run = iban_format(country, &len)) == NULL) {
+		return NULL;
+	}
+
+	num = (char*)malloc(len + 1);
+	num[0] = country[0];
+	num[1] = country[1];
+
+	for (i = 0, p = 2; i < RUNS_MAX && run[i].count > 0; i++) {
+		for (k = 0; k < run[i].count; k++, p++) {
+			switch (run[i].type) {
+			case 'a':
+				num[p] = alpha[next() % 26];
+				break;
+
+			case 'c':
+				num[p] = alnum[next() % 36];
+				break;
+
+			default:
+				num[p] = digits[next() % 10];
+				break;
+			}
+		}
+	}
+
+	num[len] = '\0';
+
+	// cyfry kontrolne = 98 - mod 97 z BBAN + kod kraju + "00"
+	for (i = 0; i < len; i++) {
+		k = (i < len - 4 ? num[i + 4] : (i == len - 4 ? num[0] : (i == len - 3 ? num[1] : '0')));
+		chk = (isalpha(k) ? chk * 100 + (k - 55) : chk * 10 + (k - '0')) % 97;
+	}
+
+	chk = 98 - chk;
+
+	if (!valid) {
+		chk = 2 + (chk - 2 + 1 + next() % 95) % 97;
+	}
+
+	num[2] = '0' + (char)(chk / 10);
+	num[3] = '0' + (char)(chk % 10);
+
+	return num;
+}
+
+static char** gen_ibans(BOOL valid)
+{
+	char** rows = dataset_new();
+	char country[3] = { 0 };
+
+	int n = 0;
+	int i;
+
+	// wszystkie kraje z tabeli formatow, na zmiane
+	while (n < DATASET) {
+		for (i = 0; i < 26 * 26 && n < DATASET; i++) {
+			country[0] = 'A' + i / 26;
+			country[1] = 'A' + i % 26;
+
+			if ((rows[n] = gen_iban(country, valid)) != NULL) {
+				n++;
+			}
+		}
+	}
+
+	return rows;
+}
+
+/////////////////////////////////////////////////////////////////
+
+static void bench_validate(const char* name, BOOL (*validate)(const char*), char** rows, BOOL expect)
+{
+	volatile size_t valid = 0;
+
+	size_t bytes = 0;
+	double start;
+	long alloc;
+
+	int i;
+
+	if (!selected(name)) {
+		return;
+	}
+
+	for (i = 0; i < ITERATIONS; i++) {
+		bytes += strlen(rows[i % DATASET]);
+	}
+
+	alloc = alloc_count();
+	start = now();
+
+	for (i = 0; i < ITERATIONS; i++) {
+		valid += validate(rows[i % DATASET]);
+	}
+
+	report(name, ITERATIONS, bytes, now() - start, alloc_count() - alloc,
+		(valid == (expect ? ITERATIONS : 0) ? TRUE : FALSE));
+}
+
+static void bench_numbers()
+{
+	char** rows;
+	char name[MAX_STRING];
+
+	int v;
+	int i;
+
+	for (v = 1; v >= 0; v--) {
+		const char* suffix = (v ? "valid" : "invalid");
+
+		rows = dataset_new();
+
+		for (i = 0; i < DATASET; i++) {
+			rows[i] = gen_number(10, wnip, v);
+		}
+
+		snprintf(name, sizeof(name), "nip:%s", suffix);
+		bench_validate(name, nip24_nip_is_valid, rows, v);
+		dataset_free(&rows);
+
+		rows = dataset_new();
+
+		for (i = 0; i < DATASET; i++) {
+			rows[i] = (i % 2 ? gen_regon14(v) : gen_number(9, w9, v));
+		}
+
+		snprintf(name, sizeof(name), "regon:%s", suffix);
+		bench_validate(name, nip24_regon_is_valid, rows, v);
+		dataset_free(&rows);
+
+		rows = dataset_new();
+
+		for (i = 0; i < DATASET; i++) {
+			rows[i] = gen_krs(v);
+		}
+
+		snprintf(name, sizeof(name), "krs:%s", suffix);
+		bench_validate(name, nip24_krs_is_valid, rows, v);
+		dataset_free(&rows);
+
+		rows = gen_ibans(v);
+
+		snprintf(name, sizeof(name), "iban:%s", suffix);
+		bench_validate(name, nip24_iban_is_valid, rows, v);
+		dataset_free(&rows);
+	}
+}
+
+static void bench_euvat()
+{
+	char** rows = dataset_new();
+	char name[MAX_STRING];
+
+	int k;
+	int i;
+
+	for (k = 0; k < (int)(sizeof(euvat) / sizeof(euvat[0])); k++) {
+		for (i = 0; i < DATASET; i++) {
+			rows[i] = (char*)euvat[k];
+		}
+
+		snprintf(name, sizeof(name), "euvat:%.2s", euvat[k]);
+		bench_validate(name, nip24_euvat_is_valid, rows, TRUE);
+	}
+
+	free(rows);
+}
+
+static void bench_rows(const char* name, char** rows, size_t (*batch)(const char* const*, size_t, uint8_t*),
+	BOOL (*single)(const char*))
+{
+	const char** all = (const char**)malloc(ROWS * sizeof(char*));
+	uint8_t* ok = (uint8_t*)malloc(ROWS);
+
+	size_t expect = 0;
+	size_t valid;
+	size_t bytes = 0;
+	double start;
+	long alloc;
+
+	int i;
+
+	if (!all || !ok || !selected(name)) {
+		goto err;
+	}
+
+	for (i = 0; i < ROWS; i++) {
+		all[i] = rows[i % DATASET];
+		bytes += strlen(all[i]);
+	}
+
+	for (i = 0; i < DATASET; i++) {
+		expect += single(rows[i]);
+	}
+
+	expect *= ROWS / DATASET;
+
+	alloc = alloc_count();
+	start = now();
+
+	valid = batch(all, ROWS, ok);
+
+	report(name, ROWS, bytes, now() - start, alloc_count() - alloc, (valid == expect ? TRUE : FALSE));
+
+err:
+	free(all);
+	free(ok);
+}
+
+static void bench_batch()
+{
+	char** rows = dataset_new();
+
+	int i;
+
+	// co czwarty numer celowo bledny
+	for (i = 0; i < DATASET; i++) {
+		rows[i] = gen_number(10, wnip, (i % 4 != 0));
+	}
+
+	bench_rows("batch:nip", rows, nip24_nip_validate_batch, nip24_nip_is_valid);
+	dataset_free(&rows);
+
+	rows = dataset_new();
+
+	for (i = 0; i < DATASET; i++) {
+		rows[i] = gen_number(9, w9, (i % 4 != 0));
+	}
+
+	bench_rows("batch:regon", rows, nip24_regon_validate_batch, nip24_regon_is_valid);
+	dataset_free(&rows);
+
+	rows = gen_ibans(TRUE);
+
+	bench_rows("batch:iban", rows, nip24_iban_validate_batch, nip24_iban_is_valid);
+	dataset_free(&rows);
+}
+
+/**
+ * Parsowanie zapisanych odpowiedzi (MSXML) oraz dekodowanie do struktur wynikowych;
+ * zliczane sa tylko alokacje sterty CRT, bez pamieci przydzielanej wewnatrz MSXML
+ */
+static void bench_decode()
+{
+	IXMLDOMDocument2* doc = NULL;
+
+	char name[MAX_STRING];
+
+	size_t bytes;
+	double start;
+	long alloc;
+	BOOL ok;
+
+	int k;
+	int i;
+
+	for (k = 0; k < (int)(sizeof(responses) / sizeof(responses[0])); k++) {
+		bytes = strlen(*responses[k].xml) * DECODES;
+
+		snprintf(name, sizeof(name), "parse:%s", responses[k].name);
+
+		if (selected(name)) {
+			ok = TRUE;
+			alloc = alloc_count();
+			start = now();
+
+			for (i = 0; i < DECODES; i++) {
+				if (!load_xml(*responses[k].xml, &doc)) {
+					ok = FALSE;
+					break;
+				}
+
+				doc->lpVtbl->Release(doc);
+				doc = NULL;
+			}
+
+			if (ok) {
+				report(name, DECODES, bytes, now() - start, alloc_count() - alloc, ok);
+			}
+			else {
+				report_err(name);
+			}
+		}
+
+		snprintf(name, sizeof(name), "decode:%s", responses[k].name);
+
+		if (selected(name)) {
+			if (!load_xml(*responses[k].xml, &doc)) {
+				report_err(name);
+				continue;
+			}
+
+			ok = TRUE;
+			alloc = alloc_count();
+			start = now();
+
+			for (i = 0; i < DECODES; i++) {
+				ok &= responses[k].decode(doc);
+			}
+
+			report(name, DECODES, bytes, now() - start, alloc_count() - alloc, ok);
+
+			doc->lpVtbl->Release(doc);
+			doc = NULL;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////
+
+static void usage()
+{
+	printf("bench [-m] [-s seed] [-f filtr]\n"
+		"  -m        wyniki w formacie TSV: nazwa, operacje, ns/op, alloc/op, MB/s, status\n"
+		"  -s seed   ziarno generatora danych testowych (domyslnie 1)\n"
+		"  -f filtr  tylko pomiary, ktorych nazwa zawiera podany ciag\n");
+}
+
+int main(int argc, char* argv[])
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-m") == 0) {
+			machine = TRUE;
+		}
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seed = _strtoui64(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (seed == 0) {
+		seed = 1;
+	}
+
+	CoInitialize(NULL);
+
+#ifdef _DEBUG
+	_CrtSetAllocHook(alloc_hook);
+#endif
+
+	if (machine) {
+		printf("name\tops\tns_op\talloc_op\tmb_s\tstatus\n");
+	}
+	else {
+		printf("ziarno: %" PRIu64 ", %d iteracji walidacji, %d dekodowan odpowiedzi\n\n", seed, ITERATIONS, DECODES);
+	}
+
+	bench_numbers();
+	bench_euvat();
+	bench_batch();
+	bench_decode();
+
+#ifdef _DEBUG
+	_CrtSetAllocHook(NULL);
+#endif
+
+	CoUninitialize();
+
+	return 0;
+}
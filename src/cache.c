@@ -0,0 +1,1308 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define CACHE_BUCKETS		1024
+#define CACHE_NEGATIVE_TTL	3600
+
+#define SKETCH_ROWS			4
+#define SKETCH_ENTRY		256
+#define SKETCH_MIN			1024
+#define SKETCH_MAX			(1 << 22)
+#define SKETCH_LIMIT		15
+
+#define TIER_TTL			0
+#define TIER_PERMANENT		1
+#define TIER_COUNT			2
+
+/**
+ * Wpis pamieci podrecznej: klucz, czas waznosci i zakodowana odpowiedz (record.c)
+ */
+typedef struct CacheEntry {
+	CacheKey key;
+	uint64_t hash;
+	time_t expires;
+	int tier;
+
+	struct CacheEntry* chain;
+	struct CacheEntry* prev;
+	struct CacheEntry* next;
+
+	size_t len;
+	uint8_t data[1];
+} CacheEntry;
+
+/**
+ * Poziom pamieci z wlasna lista LRU (head - ostatnio uzyty, tail - kandydat do usuniecia)
+ * i limitem rozmiaru. Odpowiedzi dotyczace minionych dni nie zmieniaja sie, wiec trafiaja
+ * do poziomu stalego - bez czasu waznosci, usuwane tylko z braku miejsca.
+ */
+typedef struct CacheTier {
+	CacheEntry* head;
+	CacheEntry* tail;
+
+	size_t bytes;
+	size_t max_bytes;
+} CacheTier;
+
+/**
+ * Przyblizona czestosc zapytan o klucze (count-min sketch: SKETCH_ROWS wierszy licznikow
+ * nasycanych na SKETCH_LIMIT). Po zarejestrowaniu 10 * width zapytan wszystkie liczniki sa
+ * dzielone przez 2, wiec dawna popularnosc z czasem wygasa.
+ */
+typedef struct CacheSketch {
+	uint8_t* table;
+	size_t width;
+
+	size_t samples;
+	size_t limit;
+} CacheSketch;
+
+/**
+ * Trwajace zapytanie HTTP (klucz: identyfikator klienta API i adres URL). Wykonuje je pierwszy
+ * klient, pozostali czekaja na zdarzenie done i otrzymuja kopie odpowiedzi.
+ */
+struct CacheFlight {
+	char* key;
+	HANDLE done;
+	BSTR resp;
+	int refs;
+
+	struct CacheFlight* next;
+};
+
+/**
+ * Odswiezanie w tle nieaktualnego wpisu (dla kazdego klucza co najwyzej jedno)
+ */
+typedef struct CacheRefresh {
+	CacheKey key;
+
+	struct CacheRefresh* next;
+} CacheRefresh;
+
+/**
+ * Powiazanie numeru REGON lub KRS z numerem NIP firmy, poznane z zapamietanych odpowiedzi
+ */
+typedef struct CacheAlias {
+	NIP24Key alias;
+	NIP24Key nip;
+} CacheAlias;
+
+struct NIP24Cache {
+	CRITICAL_SECTION lock;
+
+	CacheEntry** table;
+	size_t buckets;
+	size_t entries;
+
+	CacheTier tier[TIER_COUNT];
+	CacheSketch sketch;
+
+	CacheAlias* aliases;
+	size_t alias_slots;
+
+	NIP24CacheStats stats[NIP24_ENDPOINT_COUNT];
+
+	int ttl[NIP24_ENDPOINT_COUNT];
+	int stale[NIP24_ENDPOINT_COUNT];
+	int negative_ttl;
+
+	CacheShared* shared;
+	CacheStore* store;
+
+	CacheFlight* flights;
+
+	CacheRefresh* refreshes;
+	HANDLE idle;
+};
+
+// Domyslne czasy waznosci odpowiedzi w sekundach
+static const int _nip24_cache_ttl[NIP24_ENDPOINT_COUNT] = {
+	[NIP24_ENDPOINT_INVOICE] = 24 * 3600,
+	[NIP24_ENDPOINT_ALL] = 24 * 3600,
+	[NIP24_ENDPOINT_VIES] = 3600,
+	[NIP24_ENDPOINT_VAT] = 3600,
+	[NIP24_ENDPOINT_IBAN] = 3600,
+	[NIP24_ENDPOINT_WHITELIST] = 3600,
+	[NIP24_ENDPOINT_SEARCH] = 3600
+};
+
+/////////////////////////////////////////////////////////////////
+
+static uint64_t _nip24_cache_hash(const CacheKey* key)
+{
+	uint64_t h = nip24_key_hash(&key->number);
+
+	h ^= nip24_key_hash(&key->iban) * 0x9e3779b97f4a7c15ULL;
+	h ^= ((uint64_t)key->endpoint << 32 | (uint32_t)key->date) * 0xc2b2ae3d27d4eb4fULL;
+
+	return h ^ (h >> 29);
+}
+
+static size_t _nip24_cache_size(const CacheEntry* e)
+{
+	return sizeof(CacheEntry) + e->len;
+}
+
+static int _nip24_cache_today()
+{
+	struct tm* tm;
+
+	time_t now = time(NULL);
+
+	tm = localtime(&now);
+
+	return (tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 + tm->tm_mday;
+}
+
+static size_t _nip24_sketch_index(CacheSketch* sk, uint64_t hash, int row)
+{
+	hash = (hash ^ (hash >> 31)) * (0x9e3779b97f4a7c15ULL + 2 * (uint64_t)row);
+
+	return row * sk->width + (size_t)((hash >> 32) & (sk->width - 1));
+}
+
+static int _nip24_sketch_freq(CacheSketch* sk, uint64_t hash)
+{
+	int freq = SKETCH_LIMIT;
+	int i;
+
+	for (i = 0; i < SKETCH_ROWS; i++) {
+		if (sk->table[_nip24_sketch_index(sk, hash, i)] < freq) {
+			freq = sk->table[_nip24_sketch_index(sk, hash, i)];
+		}
+	}
+
+	return freq;
+}
+
+static void _nip24_sketch_add(CacheSketch* sk, uint64_t hash)
+{
+	size_t i;
+
+	int freq = _nip24_sketch_freq(sk, hash);
+	int n;
+
+	if (freq < SKETCH_LIMIT) {
+		// zwiekszane sa tylko najmniejsze liczniki, co ogranicza zawyzanie czestosci przez kolizje
+		for (n = 0; n < SKETCH_ROWS; n++) {
+			i = _nip24_sketch_index(sk, hash, n);
+
+			if (sk->table[i] == freq) {
+				sk->table[i]++;
+			}
+		}
+	}
+
+	if (++sk->samples >= sk->limit) {
+		for (i = 0; i < SKETCH_ROWS * sk->width; i++) {
+			sk->table[i] >>= 1;
+		}
+
+		sk->samples /= 2;
+	}
+}
+
+static void _nip24_cache_unlink(NIP24Cache* cache, CacheEntry* e)
+{
+	CacheTier* t = &cache->tier[e->tier];
+
+	if (e->prev) {
+		e->prev->next = e->next;
+	}
+	else {
+		t->head = e->next;
+	}
+
+	if (e->next) {
+		e->next->prev = e->prev;
+	}
+	else {
+		t->tail = e->prev;
+	}
+
+	e->prev = NULL;
+	e->next = NULL;
+}
+
+static void _nip24_cache_push(NIP24Cache* cache, CacheEntry* e)
+{
+	CacheTier* t = &cache->tier[e->tier];
+
+	e->prev = NULL;
+	e->next = t->head;
+
+	if (t->head) {
+		t->head->prev = e;
+	}
+	else {
+		t->tail = e;
+	}
+
+	t->head = e;
+}
+
+static CacheEntry** _nip24_cache_find(NIP24Cache* cache, const CacheKey* key, uint64_t hash)
+{
+	CacheEntry** p = &cache->table[hash & (cache->buckets - 1)];
+
+	for (; *p; p = &(*p)->chain) {
+		if ((*p)->hash == hash && memcmp(&(*p)->key, key, sizeof(CacheKey)) == 0) {
+			break;
+		}
+	}
+
+	return p;
+}
+
+static void _nip24_cache_remove(NIP24Cache* cache, CacheEntry** p)
+{
+	CacheEntry* e = *p;
+
+	*p = e->chain;
+
+	_nip24_cache_unlink(cache, e);
+
+	cache->entries--;
+	cache->tier[e->tier].bytes -= _nip24_cache_size(e);
+
+	cache->stats[e->key.endpoint].Entries--;
+	cache->stats[e->key.endpoint].Bytes -= _nip24_cache_size(e);
+
+	free(e);
+}
+
+static void _nip24_cache_grow(NIP24Cache* cache)
+{
+	CacheEntry** table;
+	CacheEntry* e;
+	CacheEntry* next;
+
+	size_t buckets = cache->buckets * 2;
+	size_t i;
+
+	if ((table = (CacheEntry**)calloc(buckets, sizeof(CacheEntry*))) == NULL) {
+		// pozostaja dluzsze lancuchy
+		return;
+	}
+
+	for (i = 0; i < cache->buckets; i++) {
+		for (e = cache->table[i]; e; e = next) {
+			next = e->chain;
+
+			e->chain = table[e->hash & (buckets - 1)];
+			table[e->hash & (buckets - 1)] = e;
+		}
+	}
+
+	free(cache->table);
+
+	cache->table = table;
+	cache->buckets = buckets;
+}
+
+BOOL cache_iban_key(const char* iban, NIP24Key* key)
+{
+	char str[MAX_STRING];
+
+	if (nip24_key_from_number(IBAN, iban, key)) {
+		return TRUE;
+	}
+
+	// polskie rachunki moga byc bez prefiksu PL
+	snprintf(str, sizeof(str), "PL%s", iban);
+
+	return nip24_key_from_number(IBAN, str, key);
+}
+
+static int _nip24_cache_day(time_t date)
+{
+	struct tm* tm;
+
+	// daty w odpowiedziach serwisu to polnoc UTC danego dnia
+	if ((tm = gmtime(&date)) == NULL) {
+		return 0;
+	}
+
+	return (tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 + tm->tm_mday;
+}
+
+/**
+ * Dodanie lub zastapienie wpisu (wywolywane przy zablokowanej pamieci podrecznej)
+ */
+static BOOL _nip24_cache_insert(NIP24Cache* cache, const CacheKey* key, uint64_t hash, const uint8_t* data,
+	size_t len, int tier, time_t expires)
+{
+	CacheEntry** p;
+	CacheEntry* e;
+	CacheEntry* v;
+	CacheTier* t = &cache->tier[tier];
+	NIP24CacheStats* st = &cache->stats[key->endpoint];
+
+	time_t now = time(NULL);
+	size_t bytes;
+	int freq;
+
+	if (sizeof(CacheEntry) + len > t->max_bytes) {
+		st->Rejections++;
+		return FALSE;
+	}
+
+	if ((e = (CacheEntry*)malloc(sizeof(CacheEntry) + len)) == NULL) {
+		return FALSE;
+	}
+
+	memset(e, 0, sizeof(CacheEntry));
+
+	e->key = *key;
+	e->hash = hash;
+	e->expires = expires;
+	e->tier = tier;
+	e->len = len;
+
+	memcpy(e->data, data, len);
+
+	if (*(p = _nip24_cache_find(cache, key, hash)) != NULL) {
+		// nowa wartosc zapamietanego klucza zawsze zastepuje poprzednia
+		_nip24_cache_remove(cache, p);
+	}
+	else {
+		// nowy klucz moze wyprzec najdawniej uzywane wpisy ponad limit pamieci poziomu tylko
+		// wtedy, gdy jest uzywany czesciej od kazdego z nich (TinyLFU) - jednorazowe zapytania
+		// nie wypieraja popularnych; decyzja zapada przed usunieciem czegokolwiek
+		freq = _nip24_sketch_freq(&cache->sketch, hash);
+		bytes = t->bytes;
+
+		for (v = t->tail; v && bytes + _nip24_cache_size(e) > t->max_bytes; v = v->prev) {
+			if ((v->expires == 0 || v->expires > now) && _nip24_sketch_freq(&cache->sketch, v->hash) >= freq) {
+				st->Rejections++;
+				free(e);
+				return FALSE;
+			}
+
+			bytes -= _nip24_cache_size(v);
+		}
+	}
+
+	while ((v = t->tail) != NULL && t->bytes + _nip24_cache_size(e) > t->max_bytes) {
+		if (v->expires == 0 || v->expires > now) {
+			cache->stats[v->key.endpoint].Evictions++;
+		}
+
+		_nip24_cache_remove(cache, _nip24_cache_find(cache, &v->key, v->hash));
+	}
+
+	if (cache->entries >= cache->buckets) {
+		_nip24_cache_grow(cache);
+	}
+
+	p = &cache->table[hash & (cache->buckets - 1)];
+	e->chain = *p;
+	*p = e;
+
+	_nip24_cache_push(cache, e);
+
+	cache->entries++;
+	t->bytes += _nip24_cache_size(e);
+
+	st->Entries++;
+	st->Bytes += _nip24_cache_size(e);
+
+	return TRUE;
+}
+
+/**
+ * Odtworzenie odpowiedzi lub zapamietanego bledu (code != 0)
+ */
+static void* _nip24_cache_decode(const CacheKey* key, const uint8_t* data, size_t len, int* code, char** err)
+{
+	if (record_decode_error(data, len, code, err)) {
+		return NULL;
+	}
+
+	return record_decode((Endpoint)key->endpoint, data, len);
+}
+
+/**
+ * Sprawdzenie, czy numer moze byc powiazany z numerem NIP firmy: KRS lub 9-cyfrowy REGON
+ * (14-cyfrowy REGON oznacza jednostke lokalna z wlasna nazwa i adresem)
+ */
+static BOOL _nip24_cache_alias_type(const NIP24Key* key)
+{
+	char num[MAX_NUMBER];
+
+	Number type = nip24_key_type(key);
+
+	if (type == KRS) {
+		return TRUE;
+	}
+
+	return (type == REGON && nip24_key_to_string(key, num, sizeof(num)) && strlen(num) == 9);
+}
+
+/**
+ * Dodanie powiazania numeru REGON lub KRS z numerem NIP (wywolywane przy zablokowanej
+ * pamieci podrecznej)
+ */
+static void _nip24_cache_alias_add(NIP24Cache* cache, Number type, const char* number, const NIP24Key* nip)
+{
+	CacheAlias* a;
+	NIP24Key key;
+
+	if (!number || strlen(number) == 0 || !nip24_key_from_number(type, number, &key)
+		|| !_nip24_cache_alias_type(&key)) {
+		return;
+	}
+
+	// indeks o stalym rozmiarze, nowe powiazanie zastepuje poprzednie w tym samym miejscu
+	a = &cache->aliases[nip24_key_hash(&key) & (cache->alias_slots - 1)];
+
+	memcpy(&a->alias, &key, sizeof(NIP24Key));
+	memcpy(&a->nip, nip, sizeof(NIP24Key));
+}
+
+/**
+ * Odczyt powiazan numerow z zapamietywanej odpowiedzi (pelne dane firmy, wynik wyszukiwania
+ * w rejestrze VAT z jednym podmiotem)
+ */
+static void _nip24_cache_alias_learn(NIP24Cache* cache, Endpoint endpoint, const void* obj)
+{
+	const AllData* ad;
+	const SearchResult* sr;
+	const VATEntity* ve;
+
+	NIP24Key nip;
+
+	if (endpoint == NIP24_ENDPOINT_ALL) {
+		ad = (const AllData*)obj;
+
+		if (ad->NIP && nip24_key_from_number(NIP, ad->NIP, &nip)) {
+			_nip24_cache_alias_add(cache, REGON, ad->REGON, &nip);
+		}
+	}
+	else if (endpoint == NIP24_ENDPOINT_SEARCH) {
+		sr = (const SearchResult*)obj;
+
+		if (sr->ResultsType != NIP24_RESULT_VAT_ENTITY || sr->ResultsCount != 1) {
+			return;
+		}
+
+		ve = sr->Results.VATEntity[0];
+
+		if (ve->NIP && nip24_key_from_number(NIP, ve->NIP, &nip)) {
+			_nip24_cache_alias_add(cache, REGON, ve->REGON, &nip);
+			_nip24_cache_alias_add(cache, KRS, ve->KRS, &nip);
+		}
+	}
+}
+
+/**
+ * Zamiana numeru REGON lub KRS w kluczu na znany numer NIP tej samej firmy
+ */
+static void _nip24_cache_alias_resolve(NIP24Cache* cache, CacheKey* key)
+{
+	CacheAlias* a;
+
+	// wyniki wyszukiwania sa listami podmiotow i zaleza od zapytanego numeru
+	if (key->endpoint == NIP24_ENDPOINT_SEARCH || !_nip24_cache_alias_type(&key->number)) {
+		return;
+	}
+
+	a = &cache->aliases[nip24_key_hash(&key->number) & (cache->alias_slots - 1)];
+
+	if (nip24_key_equals(&a->alias, &key->number)) {
+		memcpy(&key->number, &a->nip, sizeof(NIP24Key));
+	}
+}
+
+/**
+ * Zapamietanie zakodowanej odpowiedzi w pamieci i w magazynie na dysku (obj == NULL - zapamietany
+ * blad)
+ */
+static BOOL _nip24_cache_add(NIP24Cache* cache, const CacheKey* key, const void* obj, const uint8_t* data, size_t len)
+{
+	CacheShared* shared;
+	CacheStore* store;
+	CacheKey ck;
+
+	uint64_t hash;
+	time_t expires;
+	int tier;
+
+	BOOL negative = (obj == NULL);
+	BOOL ret;
+
+	EnterCriticalSection(&cache->lock);
+
+	// odpowiedzi dla firmy zapytanej przez REGON lub KRS zapisywane sa pod jej numerem NIP
+	if (obj) {
+		_nip24_cache_alias_learn(cache, (Endpoint)key->endpoint, obj);
+	}
+
+	memcpy(&ck, key, sizeof(CacheKey));
+	_nip24_cache_alias_resolve(cache, &ck);
+
+	key = &ck;
+	hash = _nip24_cache_hash(key);
+
+	shared = cache->shared;
+	store = cache->store;
+
+	if (negative && cache->negative_ttl > 0) {
+		tier = TIER_TTL;
+		expires = time(NULL) + cache->negative_ttl;
+	}
+	else if (negative) {
+		LeaveCriticalSection(&cache->lock);
+		return FALSE;
+	}
+	else if (key->date != 0 && key->date < _nip24_cache_today() && cache->tier[TIER_PERMANENT].max_bytes > 0) {
+		tier = TIER_PERMANENT;
+		expires = 0;
+	}
+	else if (cache->ttl[key->endpoint] > 0) {
+		tier = TIER_TTL;
+		expires = time(NULL) + cache->ttl[key->endpoint];
+	}
+	else {
+		LeaveCriticalSection(&cache->lock);
+		return FALSE;
+	}
+
+	ret = _nip24_cache_insert(cache, key, hash, data, len, tier, expires);
+
+	LeaveCriticalSection(&cache->lock);
+
+	// pozostale poziomy moga przechowywac odpowiedzi, ktore nie mieszcza sie w pamieci procesu
+	if (shared && shared_put(shared, key, hash, data, len, expires)) {
+		ret = TRUE;
+	}
+
+	if (store && store_put(store, key, hash, data, len, expires)) {
+		ret = TRUE;
+	}
+
+	return ret;
+}
+
+static void _nip24_cache_flight_release(CacheFlight* flight)
+{
+	if (--flight->refs > 0) {
+		return;
+	}
+
+	CloseHandle(flight->done);
+	SysFreeString(flight->resp);
+
+	free(flight->key);
+	free(flight);
+}
+
+/////////////////////////////////////////////////////////////////
+
+BOOL cache_key(CacheKey* key, Endpoint endpoint, Number type, const char* number, const char* iban, int date)
+{
+	memset(key, 0, sizeof(CacheKey));
+
+	if (!number) {
+		return FALSE;
+	}
+
+	if (type == IBAN) {
+		if (!cache_iban_key(number, &key->number)) {
+			return FALSE;
+		}
+	}
+	else if (!nip24_key_from_number(type, number, &key->number)) {
+		return FALSE;
+	}
+
+	if (iban && !cache_iban_key(iban, &key->iban)) {
+		return FALSE;
+	}
+
+	key->endpoint = endpoint;
+	key->date = date;
+
+	return TRUE;
+}
+
+/**
+ * Odczyt odpowiedzi ze wszystkich poziomow pamieci podrecznej
+ * @param count TRUE - odczyt jest liczony w statystykach metody i w szkicu czestotliwosci
+ */
+static void* _nip24_cache_lookup(NIP24Cache* cache, const CacheKey* key, int* code, char** err, BOOL* stale,
+	BOOL count)
+{
+	CacheEntry** p;
+	CacheShared* shared;
+	CacheStore* store;
+	CacheKey ck;
+
+	uint64_t hash;
+	uint8_t* data = NULL;
+	size_t len;
+	time_t expires;
+	time_t now = time(NULL);
+
+	void* obj = NULL;
+
+	*code = 0;
+	*err = NULL;
+
+	if (stale) {
+		*stale = FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	shared = cache->shared;
+	store = cache->store;
+
+	memcpy(&ck, key, sizeof(CacheKey));
+	_nip24_cache_alias_resolve(cache, &ck);
+
+	key = &ck;
+	hash = _nip24_cache_hash(key);
+
+	if (count) {
+		_nip24_sketch_add(&cache->sketch, hash);
+	}
+
+	if (*(p = _nip24_cache_find(cache, key, hash)) != NULL) {
+		if ((*p)->expires == 0 || (*p)->expires > now) {
+			_nip24_cache_unlink(cache, *p);
+			_nip24_cache_push(cache, *p);
+
+			// kazde trafienie zwraca nowa kopie, zwalniana przez wywolujacego
+			obj = _nip24_cache_decode(key, (*p)->data, (*p)->len, code, err);
+
+			if (count) {
+				cache->stats[key->endpoint].Hits++;
+			}
+
+			LeaveCriticalSection(&cache->lock);
+			return obj;
+		}
+
+		// nieaktualna odpowiedz (ale nie odpowiedz negatywna) w okresie karencji
+		if (stale && (*p)->expires + cache->stale[key->endpoint] > now
+			&& (obj = _nip24_cache_decode(key, (*p)->data, (*p)->len, code, err)) != NULL) {
+			*stale = TRUE;
+
+			if (count) {
+				cache->stats[key->endpoint].Hits++;
+				cache->stats[key->endpoint].Stale++;
+			}
+
+			LeaveCriticalSection(&cache->lock);
+			return obj;
+		}
+
+		free(*err);
+
+		*code = 0;
+		*err = NULL;
+
+		_nip24_cache_remove(cache, p);
+	}
+
+	LeaveCriticalSection(&cache->lock);
+
+	// odczyt z pamieci wspoldzielonej i z dysku odbywa sie bez blokady pamieci podrecznej
+	if (!shared || !shared_get(shared, key, hash, &data, &len, &expires)) {
+		if (!store || !store_get(store, key, hash, &data, &len, &expires)) {
+			goto err;
+		}
+
+		if (shared) {
+			shared_put(shared, key, hash, data, len, expires);
+		}
+	}
+
+	if ((obj = _nip24_cache_decode(key, data, len, code, err)) == NULL && *code == 0) {
+		goto err;
+	}
+
+	EnterCriticalSection(&cache->lock);
+	_nip24_cache_insert(cache, key, hash, data, len, (expires == 0 ? TIER_PERMANENT : TIER_TTL), expires);
+	LeaveCriticalSection(&cache->lock);
+
+err:
+	if (count) {
+		EnterCriticalSection(&cache->lock);
+
+		if (obj || *code != 0) {
+			cache->stats[key->endpoint].Hits++;
+		}
+		else {
+			cache->stats[key->endpoint].Misses++;
+		}
+
+		LeaveCriticalSection(&cache->lock);
+	}
+
+	free(data);
+
+	return obj;
+}
+
+void* cache_get(NIP24Cache* cache, const CacheKey* key, int* code, char** err, BOOL* stale)
+{
+	return _nip24_cache_lookup(cache, key, code, err, stale, TRUE);
+}
+
+void* cache_peek(NIP24Cache* cache, const CacheKey* key, int* code, char** err, BOOL* stale)
+{
+	// odczyt pomocniczy (np. wyznaczanie odpowiedzi innej metody, rozgrzewanie) nie jest
+	// zapytaniem uzytkownika
+	return _nip24_cache_lookup(cache, key, code, err, stale, FALSE);
+}
+
+BOOL cache_put(NIP24Cache* cache, const CacheKey* key, const void* obj)
+{
+	uint8_t* data = NULL;
+	size_t len;
+
+	BOOL ret = FALSE;
+
+	if (key->endpoint < 0 || key->endpoint >= NIP24_ENDPOINT_COUNT) {
+		return FALSE;
+	}
+
+	if (record_encode((Endpoint)key->endpoint, obj, &data, &len)) {
+		ret = _nip24_cache_add(cache, key, obj, data, len);
+	}
+
+	free(data);
+
+	return ret;
+}
+
+BOOL cache_firm_error(int code)
+{
+	// bledy wynikajace ze stanu firmy - takie same dla kazdego konta, w odroznieniu od bledow
+	// uprawnien, planu lub autoryzacji i chwilowych problemow serwisu
+	return (code == NIP24_ERR_NIP_NOT_ACTIVE || code == NIP24_ERR_NIP_UNKNOWN || code == NIP24_ERR_NIP_BAD);
+}
+
+BOOL cache_put_error(NIP24Cache* cache, const CacheKey* key, int code, const char* err)
+{
+	uint8_t* data = NULL;
+	size_t len;
+
+	BOOL ret = FALSE;
+
+	if (!cache_firm_error(code)) {
+		return FALSE;
+	}
+
+	if (key->endpoint < 0 || key->endpoint >= NIP24_ENDPOINT_COUNT) {
+		return FALSE;
+	}
+
+	if (record_encode_error(code, err, &data, &len)) {
+		ret = _nip24_cache_add(cache, key, NULL, data, len);
+	}
+
+	free(data);
+
+	return ret;
+}
+
+CacheFlight* cache_flight_join(NIP24Cache* cache, const char* url, BOOL* leader)
+{
+	CacheFlight* f;
+
+	char* key;
+
+	*leader = TRUE;
+
+	// dane firm nie zaleza od konta (tak jak klucze pamieci podrecznej), bledy zalezne od konta
+	// nie sa przejmowane przez oczekujacych (zob. _nip24_http_get)
+	if ((key = strdup(url)) == NULL) {
+		return NULL;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	for (f = cache->flights; f; f = f->next) {
+		if (strcmp(f->key, key) == 0) {
+			break;
+		}
+	}
+
+	if (f) {
+		f->refs++;
+		*leader = FALSE;
+	}
+	else if ((f = (CacheFlight*)malloc(sizeof(CacheFlight))) != NULL) {
+		memset(f, 0, sizeof(CacheFlight));
+
+		if ((f->done = CreateEvent(NULL, TRUE, FALSE, NULL)) != NULL) {
+			f->key = key;
+			f->refs = 1;
+			f->next = cache->flights;
+
+			cache->flights = f;
+			key = NULL;
+		}
+		else {
+			free(f);
+			f = NULL;
+		}
+	}
+
+	LeaveCriticalSection(&cache->lock);
+
+	free(key);
+
+	return f;
+}
+
+void cache_flight_done(NIP24Cache* cache, CacheFlight* flight, const BSTR resp)
+{
+	CacheFlight** p;
+
+	EnterCriticalSection(&cache->lock);
+
+	// kolejne zapytania o ten sam adres wysylane sa juz od nowa
+	for (p = &cache->flights; *p; p = &(*p)->next) {
+		if (*p == flight) {
+			*p = flight->next;
+			break;
+		}
+	}
+
+	flight->resp = (resp ? SysAllocStringLen(resp, SysStringLen(resp)) : NULL);
+
+	SetEvent(flight->done);
+
+	_nip24_cache_flight_release(flight);
+
+	LeaveCriticalSection(&cache->lock);
+}
+
+BOOL cache_flight_wait(NIP24Cache* cache, CacheFlight* flight, BSTR* resp)
+{
+	BOOL ret = FALSE;
+
+	WaitForSingleObject(flight->done, INFINITE);
+
+	EnterCriticalSection(&cache->lock);
+
+	if (flight->resp && (*resp = SysAllocStringLen(flight->resp, SysStringLen(flight->resp))) != NULL) {
+		ret = TRUE;
+	}
+
+	_nip24_cache_flight_release(flight);
+
+	LeaveCriticalSection(&cache->lock);
+
+	return ret;
+}
+
+BOOL cache_refresh_begin(NIP24Cache* cache, const CacheKey* key)
+{
+	CacheRefresh* r;
+
+	BOOL ret = FALSE;
+
+	EnterCriticalSection(&cache->lock);
+
+	for (r = cache->refreshes; r; r = r->next) {
+		if (memcmp(&r->key, key, sizeof(CacheKey)) == 0) {
+			goto err;
+		}
+	}
+
+	if ((r = (CacheRefresh*)malloc(sizeof(CacheRefresh))) == NULL) {
+		goto err;
+	}
+
+	memcpy(&r->key, key, sizeof(CacheKey));
+
+	r->next = cache->refreshes;
+	cache->refreshes = r;
+
+	ResetEvent(cache->idle);
+
+	// ok
+	ret = TRUE;
+
+err:
+	LeaveCriticalSection(&cache->lock);
+
+	return ret;
+}
+
+void cache_refresh_end(NIP24Cache* cache, const CacheKey* key)
+{
+	CacheRefresh** p;
+	CacheRefresh* r;
+
+	EnterCriticalSection(&cache->lock);
+
+	for (p = &cache->refreshes; *p; p = &(*p)->next) {
+		if (memcmp(&(*p)->key, key, sizeof(CacheKey)) == 0) {
+			r = *p;
+			*p = r->next;
+
+			free(r);
+			break;
+		}
+	}
+
+	if (!cache->refreshes) {
+		SetEvent(cache->idle);
+	}
+
+	LeaveCriticalSection(&cache->lock);
+}
+
+/////////////////////////////////////////////////////////////////
+
+NIP24_API BOOL nip24_cache_new(NIP24Cache** cache, size_t max_bytes)
+{
+	NIP24Cache* c = NULL;
+
+	BOOL ret = FALSE;
+
+	if (!cache || max_bytes == 0) {
+		goto err;
+	}
+
+	if ((c = (NIP24Cache*)malloc(sizeof(NIP24Cache))) == NULL) {
+		goto err;
+	}
+
+	memset(c, 0, sizeof(NIP24Cache));
+
+	if ((c->table = (CacheEntry**)calloc(CACHE_BUCKETS, sizeof(CacheEntry*))) == NULL) {
+		goto err;
+	}
+
+	// szerokosc szkicu odpowiada szacowanej liczbie wpisow
+	for (c->sketch.width = SKETCH_MIN; c->sketch.width < SKETCH_MAX
+		&& c->sketch.width < max_bytes / SKETCH_ENTRY; c->sketch.width *= 2);
+
+	if ((c->sketch.table = (uint8_t*)calloc(SKETCH_ROWS, c->sketch.width)) == NULL) {
+		goto err;
+	}
+
+	c->sketch.limit = 10 * c->sketch.width;
+
+	// indeks numerow REGON i KRS o rozmiarze szkicu
+	c->alias_slots = c->sketch.width;
+
+	if ((c->aliases = (CacheAlias*)calloc(c->alias_slots, sizeof(CacheAlias))) == NULL) {
+		goto err;
+	}
+
+	// zdarzenie ustawione, gdy w tle nie sa odswiezane zadne wpisy
+	if ((c->idle = CreateEvent(NULL, TRUE, TRUE, NULL)) == NULL) {
+		goto err;
+	}
+
+	InitializeCriticalSection(&c->lock);
+
+	c->buckets = CACHE_BUCKETS;
+
+	c->tier[TIER_TTL].max_bytes = max_bytes;
+	c->tier[TIER_PERMANENT].max_bytes = max_bytes;
+
+	memcpy(c->ttl, _nip24_cache_ttl, sizeof(c->ttl));
+	c->negative_ttl = CACHE_NEGATIVE_TTL;
+
+	// ok
+	*cache = c;
+	c = NULL;
+
+	ret = TRUE;
+
+err:
+	if (c) {
+		if (c->idle) {
+			CloseHandle(c->idle);
+		}
+
+		free(c->aliases);
+		free(c->sketch.table);
+		free(c->table);
+		free(c);
+	}
+
+	return ret;
+}
+
+NIP24_API void nip24_cache_free(NIP24Cache** cache)
+{
+	NIP24Cache* c = (cache ? *cache : NULL);
+
+	if (c) {
+		// zakonczenie odswiezania w tle
+		WaitForSingleObject(c->idle, INFINITE);
+
+		nip24_cache_clear(c);
+
+		shared_close(&c->shared);
+		store_close(&c->store);
+
+		DeleteCriticalSection(&c->lock);
+		CloseHandle(c->idle);
+
+		free(c->aliases);
+		free(c->sketch.table);
+		free(c->table);
+
+		free(*cache);
+		*cache = NULL;
+	}
+}
+
+NIP24_API BOOL nip24_cache_open_store(NIP24Cache* cache, const char* path)
+{
+	CacheStore* store = NULL;
+
+	BOOL ret = FALSE;
+
+	if (!cache || !path) {
+		return FALSE;
+	}
+
+	if (!store_open(&store, path)) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	if (!cache->store) {
+		cache->store = store;
+		store = NULL;
+
+		ret = TRUE;
+	}
+
+	LeaveCriticalSection(&cache->lock);
+
+	store_close(&store);
+
+	return ret;
+}
+
+NIP24_API BOOL nip24_cache_open_shared(NIP24Cache* cache, const char* name, size_t max_bytes)
+{
+	CacheShared* shared = NULL;
+
+	BOOL ret = FALSE;
+
+	if (!cache || !name) {
+		return FALSE;
+	}
+
+	if (!shared_open(&shared, name, max_bytes)) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	if (!cache->shared) {
+		cache->shared = shared;
+		shared = NULL;
+
+		ret = TRUE;
+	}
+
+	LeaveCriticalSection(&cache->lock);
+
+	shared_close(&shared);
+
+	return ret;
+}
+
+NIP24_API BOOL nip24_cache_set_ttl(NIP24Cache* cache, Endpoint endpoint, int ttl)
+{
+	if (!cache || endpoint < 0 || endpoint >= NIP24_ENDPOINT_COUNT || ttl < 0) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+	cache->ttl[endpoint] = ttl;
+	LeaveCriticalSection(&cache->lock);
+
+	return TRUE;
+}
+
+NIP24_API BOOL nip24_cache_set_negative_ttl(NIP24Cache* cache, int ttl)
+{
+	if (!cache || ttl < 0) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+	cache->negative_ttl = ttl;
+	LeaveCriticalSection(&cache->lock);
+
+	return TRUE;
+}
+
+NIP24_API BOOL nip24_cache_set_stale(NIP24Cache* cache, Endpoint endpoint, int grace)
+{
+	if (!cache || endpoint != NIP24_ENDPOINT_INVOICE || grace < 0) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+	cache->stale[endpoint] = grace;
+	LeaveCriticalSection(&cache->lock);
+
+	return TRUE;
+}
+
+NIP24_API void nip24_cache_clear(NIP24Cache* cache)
+{
+	CacheEntry* e;
+	CacheEntry* next;
+
+	int i;
+
+	if (!cache) {
+		return;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	for (i = 0; i < TIER_COUNT; i++) {
+		for (e = cache->tier[i].head; e; e = next) {
+			next = e->next;
+			free(e);
+		}
+
+		cache->tier[i].head = NULL;
+		cache->tier[i].tail = NULL;
+		cache->tier[i].bytes = 0;
+	}
+
+	memset(cache->table, 0, cache->buckets * sizeof(CacheEntry*));
+	memset(cache->aliases, 0, cache->alias_slots * sizeof(CacheAlias));
+
+	cache->entries = 0;
+
+	for (i = 0; i < NIP24_ENDPOINT_COUNT; i++) {
+		cache->stats[i].Entries = 0;
+		cache->stats[i].Bytes = 0;
+	}
+
+	LeaveCriticalSection(&cache->lock);
+}
+
+NIP24_API BOOL nip24_cache_stats(NIP24Cache* cache, Endpoint endpoint, NIP24CacheStats* stats)
+{
+	if (!cache || endpoint < 0 || endpoint >= NIP24_ENDPOINT_COUNT || !stats) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+	memcpy(stats, &cache->stats[endpoint], sizeof(NIP24CacheStats));
+	LeaveCriticalSection(&cache->lock);
+
+	return TRUE;
+}
+
+NIP24_API BOOL nip24_cache_set_permanent_limit(NIP24Cache* cache, size_t max_bytes)
+{
+	CacheEntry* v;
+
+	if (!cache) {
+		return FALSE;
+	}
+
+	EnterCriticalSection(&cache->lock);
+
+	cache->tier[TIER_PERMANENT].max_bytes = max_bytes;
+
+	while ((v = cache->tier[TIER_PERMANENT].tail) != NULL && cache->tier[TIER_PERMANENT].bytes > max_bytes) {
+		cache->stats[v->key.endpoint].Evictions++;
+		_nip24_cache_remove(cache, _nip24_cache_find(cache, &v->key, v->hash));
+	}
+
+	LeaveCriticalSection(&cache->lock);
+
+	return TRUE;
+}
+
+NIP24_API int nip24_cache_preload_whitelist(NIP24Cache* cache, WLStatus* const* ws, int count)
+{
+	CacheKey key;
+
+	int n = 0;
+	int i;
+
+	if (!cache || !ws) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!ws[i] || ws[i]->Date <= 0) {
+			continue;
+		}
+
+		if (!cache_key(&key, NIP24_ENDPOINT_WHITELIST, NIP, ws[i]->NIP, ws[i]->IBAN, _nip24_cache_day(ws[i]->Date))) {
+			continue;
+		}
+
+		if (cache_put(cache, &key, ws[i])) {
+			n++;
+		}
+	}
+
+	return n;
+}
+
+NIP24_API int nip24_cache_preload_iban(NIP24Cache* cache, IBANStatus* const* is, int count)
+{
+	CacheKey key;
+
+	int n = 0;
+	int i;
+
+	if (!cache || !is) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!is[i] || is[i]->Date <= 0) {
+			continue;
+		}
+
+		if (!cache_key(&key, NIP24_ENDPOINT_IBAN, NIP, is[i]->NIP, is[i]->IBAN, _nip24_cache_day(is[i]->Date))) {
+			continue;
+		}
+
+		if (cache_put(cache, &key, is[i])) {
+			n++;
+		}
+	}
+
+	return n;
+}
@@ -22,6 +22,30 @@
 #include "nip24.h"
 
 
+/**
+ * Zadanie odswiezenia w tle nieaktualnej odpowiedzi z pamieci podrecznej
+ */
+typedef struct RefreshTask {
+	NIP24Client* nip24;
+
+	CacheKey key;
+	Number type;
+	char number[MAX_STRING];
+} RefreshTask;
+
+/**
+ * Ostatni blad zgloszony w jednym watku
+ */
+struct NIP24ClientError {
+	int code;
+	char* err;
+
+	struct NIP24ClientError* prev;
+	struct NIP24ClientError* next;
+};
+
+/////////////////////////////////////////////////////////////////
+
 /**
  * Zwraca losowy ciag w postaci heksadecymalnej
  * @param length zadana dlugosc ciagu
@@ -291,13 +315,13 @@ err:
 }
 
 /**
- * Metoda HTTP GET
+ * Wyslanie zapytania HTTP GET
  * @param nip24 obiekt klienta
  * @param url adres URL
- * @param adres na obiekt dokumentu XML
+ * @param resp adres na tresc odpowiedzi
  * @return TRUE jezeli OK, FALSE w przypadku bledu
  */
-static BOOL _nip24_http_get(NIP24Client* nip24, const char* url, IXMLDOMDocument2** doc)
+static BOOL _nip24_http_send(NIP24Client* nip24, const char* url, BSTR* resp)
 {
 	IXMLHTTPRequest* pXhr = NULL;
 
@@ -308,7 +332,7 @@ static BOOL _nip24_http_get(NIP24Client* nip24, const char* url, IXMLDOMDocument
 	BSTR burl = NULL;
 	BSTR auth = NULL;
 	BSTR agent = NULL;
-	BSTR resp = NULL;
+	BSTR text = NULL;
 
 	BOOL ret = FALSE;
 
@@ -374,13 +398,12 @@ static BOOL _nip24_http_get(NIP24Client* nip24, const char* url, IXMLDOMDocument
 		goto err;
 	}
 
-	if ((hr = pXhr->lpVtbl->get_responseText(pXhr, &resp)) != S_OK) {
+	if ((hr = pXhr->lpVtbl->get_responseText(pXhr, &text)) != S_OK) {
 		goto err;
 	}
 
-	if (!_nip24_load_doc(resp, doc)) {
-		goto err;
-	}
+	*resp = text;
+	text = NULL;
 
 	// ok
 	ret = TRUE;
@@ -393,21 +416,184 @@ err:
 	SysFreeString(burl);
 	SysFreeString(auth);
 	SysFreeString(agent);
+	SysFreeString(text);
+
+	return ret;
+}
+
+static char* _nip24_parse_str(IXMLDOMDocument2* doc, BSTR xpath, const char* def);
+
+/**
+ * Sprawdzenie, czy odpowiedz na zapytanie innego klienta moze zostac przejeta (dane firmy
+ * lub blad wynikajacy ze stanu firmy, a nie z uprawnien, planu czy autoryzacji konta)
+ * @param doc obiekt dokumentu XML
+ * @return TRUE jezeli odpowiedz nie zalezy od konta
+ */
+static BOOL _nip24_flight_shared(IXMLDOMDocument2* doc)
+{
+	char* code = _nip24_parse_str(doc, L"/result/error/code", NULL);
+
+	BOOL ret = (!code || strlen(code) == 0 || cache_firm_error(atoi(code)));
+
+	free(code);
+
+	return ret;
+}
+
+/**
+ * Metoda HTTP GET. Klienci korzystajacy z tej samej pamieci podrecznej nie powtarzaja
+ * trwajacych zapytan: pierwszy wysyla zapytanie, a pozostali czekaja na jego odpowiedz.
+ * @param nip24 obiekt klienta
+ * @param url adres URL
+ * @param adres na obiekt dokumentu XML
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+static BOOL _nip24_http_get(NIP24Client* nip24, const char* url, IXMLDOMDocument2** doc)
+{
+	CacheFlight* flight = NULL;
+
+	BSTR resp = NULL;
+
+	BOOL leader = TRUE;
+	BOOL sent;
+	BOOL ret = FALSE;
+
+	if (nip24->cache) {
+		flight = cache_flight_join(nip24->cache, url, &leader);
+	}
+
+	if (leader) {
+		sent = _nip24_http_send(nip24, url, &resp);
+
+		if (flight) {
+			cache_flight_done(nip24->cache, flight, (sent ? resp : NULL));
+		}
+	}
+	else {
+		sent = cache_flight_wait(nip24->cache, flight, &resp);
+	}
+
+	if (!sent) {
+		goto err;
+	}
+
+	if (!_nip24_load_doc(resp, doc)) {
+		goto err;
+	}
+
+	// blad zalezny od konta innego klienta - zapytanie jest wysylane ponownie z wlasnymi
+	// danymi autoryzacji
+	if (!leader && !_nip24_flight_shared(*doc)) {
+		(*doc)->lpVtbl->Release(*doc);
+		*doc = NULL;
+
+		SysFreeString(resp);
+		resp = NULL;
+
+		if (!_nip24_http_send(nip24, url, &resp) || !_nip24_load_doc(resp, doc)) {
+			goto err;
+		}
+	}
+
+	// ok
+	ret = TRUE;
+
+err:
 	SysFreeString(resp);
 
 	return ret;
 }
 
+/**
+ * Pobranie ostatniego bledu biezacego watku. Wpis jest tworzony przy pierwszym uzyciu klienta
+ * w watku i pozniej odczytywany bez blokady z pamieci TLS klienta; blokada chroni tylko liste
+ * wszystkich wpisow (zwalnianych przez nip24_free).
+ * @param nip24 obiekt klienta
+ * @return wpis bledu lub NULL w przypadku braku pamieci
+ */
+static struct NIP24ClientError* _nip24_get_err(NIP24Client* nip24)
+{
+	struct NIP24ClientError* e;
+
+	if ((e = (struct NIP24ClientError*)TlsGetValue(nip24->tls)) != NULL) {
+		return e;
+	}
+
+	if ((e = (struct NIP24ClientError*)malloc(sizeof(struct NIP24ClientError))) == NULL) {
+		return NULL;
+	}
+
+	memset(e, 0, sizeof(struct NIP24ClientError));
+
+	if (!TlsSetValue(nip24->tls, e)) {
+		free(e);
+		return NULL;
+	}
+
+	EnterCriticalSection(&nip24->lock);
+
+	e->next = nip24->errors;
+
+	if (e->next) {
+		e->next->prev = e;
+	}
+
+	nip24->errors = e;
+
+	LeaveCriticalSection(&nip24->lock);
+
+	return e;
+}
+
+/**
+ * Zwolnienie wpisu bledu biezacego watku (wywolywane przez konczace sie watki robocze)
+ * @param nip24 obiekt klienta
+ */
+void client_release_err(NIP24Client* nip24)
+{
+	struct NIP24ClientError* e;
+
+	if (!nip24 || (e = (struct NIP24ClientError*)TlsGetValue(nip24->tls)) == NULL) {
+		return;
+	}
+
+	TlsSetValue(nip24->tls, NULL);
+
+	EnterCriticalSection(&nip24->lock);
+
+	if (e->prev) {
+		e->prev->next = e->next;
+	}
+	else {
+		nip24->errors = e->next;
+	}
+
+	if (e->next) {
+		e->next->prev = e->prev;
+	}
+
+	LeaveCriticalSection(&nip24->lock);
+
+	free(e->err);
+	free(e);
+}
+
 /**
  * Wyzerowanie ostatniego bledu
  * @param nip24 obiekt klienta
  */
 static void _nip24_clear_err(NIP24Client* nip24)
 {
-	nip24->err_code = 0;
+	struct NIP24ClientError* e;
 
-	free(nip24->err);
-	nip24->err = NULL;
+	if (!nip24 || (e = _nip24_get_err(nip24)) == NULL) {
+		return;
+	}
+
+	e->code = 0;
+
+	free(e->err);
+	e->err = NULL;
 }
 
 /**
@@ -418,10 +604,36 @@ static void _nip24_clear_err(NIP24Client* nip24)
  */
 static void _nip24_set_err(NIP24Client* nip24, int code, const char* err)
 {
-	_nip24_clear_err(nip24);
+	struct NIP24ClientError* e;
 
-	nip24->err_code = code;
-	nip24->err = strdup(err ? err : nip24_errstr(code));
+	if (!nip24 || (e = _nip24_get_err(nip24)) == NULL) {
+		return;
+	}
+
+	free(e->err);
+
+	e->code = code;
+	e->err = strdup(err ? err : nip24_errstr(code));
+}
+
+/**
+ * Sprawdzenie i normalizacja numeru IBAN (polskie rachunki moga byc bez prefiksu PL)
+ * @param iban numer IBAN w dowolnym formacie
+ * @param out bufor na znormalizowany numer IBAN
+ * @param size rozmiar bufora
+ * @return TRUE jezeli OK, FALSE jezeli numer jest nieprawidlowy
+ */
+static BOOL _nip24_check_iban(const char* iban, char* out, size_t size)
+{
+	char iban_str[MAX_STRING];
+
+	if (nip24_number_check(IBAN, iban, out, size)) {
+		return TRUE;
+	}
+
+	snprintf(iban_str, sizeof(iban_str), "PL%s", iban);
+
+	return nip24_number_check(IBAN, iban_str, out, size);
 }
 
 /**
@@ -434,80 +646,52 @@ static void _nip24_set_err(NIP24Client* nip24, int code, const char* err)
  */
 static BOOL _nip24_get_path_suffix(NIP24Client* nip24, Number type, const char* number, char* path)
 {
-	char iban_str[MAX_STRING];
-
-	char* n = NULL;
+	char n[MAX_NUMBER];
 
 	if (type == NIP) {
-		if (!nip24_nip_is_valid(number)) {
+		if (!nip24_number_check(NIP, number, n, sizeof(n))) {
 			_nip24_set_err(nip24, NIP24_ERR_CLI_NIP, NULL);
 			return FALSE;
 		}
 
-		n = nip24_nip_normalize(number);
-
 		strcat(path, "nip/");
 		strcat(path, n);
-
-		free(n);
 	}
 	else if (type == REGON) {
-		if (!nip24_regon_is_valid(number)) {
+		if (!nip24_number_check(REGON, number, n, sizeof(n))) {
 			_nip24_set_err(nip24, NIP24_ERR_CLI_REGON, NULL);
 			return FALSE;
 		}
 
-		n = nip24_regon_normalize(number);
-
 		strcat(path, "regon/");
 		strcat(path, n);
-
-		free(n);
 	}
 	else if (type == KRS) {
-		if (!nip24_krs_is_valid(number)) {
+		if (!nip24_number_check(KRS, number, n, sizeof(n))) {
 			_nip24_set_err(nip24, NIP24_ERR_CLI_KRS, NULL);
 			return FALSE;
 		}
 
-		n = nip24_krs_normalize(number);
-
 		strcat(path, "krs/");
 		strcat(path, n);
-
-		free(n);
 	}
 	else if (type == EUVAT) {
-		if (!nip24_euvat_is_valid(number)) {
+		if (!nip24_number_check(EUVAT, number, n, sizeof(n))) {
 			_nip24_set_err(nip24, NIP24_ERR_CLI_EUVAT, NULL);
 			return FALSE;
 		}
 
-		n = nip24_euvat_normalize(number);
-
 		strcat(path, "euvat/");
 		strcat(path, n);
-
-		free(n);
 	}
 	else if (type == IBAN) {
-		snprintf(iban_str, sizeof(iban_str), "%s", number);
-
-		if (!nip24_iban_is_valid(iban_str)) {
-			snprintf(iban_str, sizeof(iban_str), "PL%s", number);
-
-			if (!nip24_iban_is_valid(iban_str)) {
-				_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
-				return FALSE;
-			}
+		if (!_nip24_check_iban(number, n, sizeof(n))) {
+			_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
+			return FALSE;
 		}
 
-		n = nip24_iban_normalize(iban_str);
-
 		strcat(path, "iban/");
 		strcat(path, n);
-
-		free(n);
 	}
 	else {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_NUMBER, NULL);
@@ -517,6 +701,139 @@ static BOOL _nip24_get_path_suffix(NIP24Client* nip24, Number type, const char*
 	return TRUE;
 }
 
+/**
+ * Przygotowanie klucza pamieci podrecznej
+ * @param nip24 obiekt klienta
+ * @param endpoint metoda API
+ * @param type typ numeru identyfikujacego firme
+ * @param number numer okreslonego typu
+ * @param iban znormalizowany numer IBAN lub NULL
+ * @param date dzien, ktorego dotyczy zapytanie lub 0
+ * @param key adres na klucz
+ * @return TRUE jezeli klient korzysta z pamieci podrecznej i klucz zostal utworzony
+ */
+static BOOL _nip24_cache_key(NIP24Client* nip24, Endpoint endpoint, Number type, const char* number,
+	const char* iban, time_t date, CacheKey* key)
+{
+	struct tm* tm;
+
+	int day = 0;
+
+	if (!nip24->cache) {
+		return FALSE;
+	}
+
+	if (date > 0) {
+		tm = localtime(&date);
+		day = (tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 + tm->tm_mday;
+	}
+
+	return cache_key(key, endpoint, type, number, iban, day);
+}
+
+/**
+ * Odczyt odpowiedzi z pamieci podrecznej; zapamietana odpowiedz negatywna ustawia blad
+ * tak samo jak odpowiedz serwisu
+ * @param nip24 obiekt klienta
+ * @param key klucz odpowiedzi
+ * @param stale adres na znacznik nieaktualnej odpowiedzi lub NULL, jezeli nie moze byc zwrocona
+ * @param obj adres na kopie odpowiedzi (NULL dla odpowiedzi negatywnej)
+ * @return TRUE jezeli odpowiedz znaleziono w pamieci podrecznej
+ */
+static BOOL _nip24_cache_get(NIP24Client* nip24, const CacheKey* key, BOOL* stale, void** obj)
+{
+	char* err;
+	int code;
+
+	if ((*obj = cache_get(nip24->cache, key, &code, &err, stale)) != NULL) {
+		return TRUE;
+	}
+
+	if (code == 0) {
+		return FALSE;
+	}
+
+	_nip24_set_err(nip24, code, err);
+	free(err);
+
+	return TRUE;
+}
+
+/**
+ * Watek odswiezajacy nieaktualne dane do faktury
+ * @param param zadanie odswiezenia
+ * @return 0
+ */
+static DWORD WINAPI _nip24_refresh_proc(LPVOID param)
+{
+	RefreshTask* t = (RefreshTask*)param;
+	InvoiceData* id;
+
+	CoInitialize(NULL);
+
+	// zwykla sciezka zapytania zapisuje odpowiedz w pamieci podrecznej
+	id = nip24_get_invoice_data(t->nip24, t->type, t->number, TRUE);
+	invoicedata_free(&id);
+
+	cache_refresh_end(t->nip24->cache, &t->key);
+
+	CoUninitialize();
+
+	nip24_free(&t->nip24);
+	free(t);
+
+	return 0;
+}
+
+/**
+ * Uruchomienie w tle odswiezania nieaktualnych danych do faktury (jezeli dla tego klucza
+ * nie jest juz odswiezane). Zapytanie wysyla osobny obiekt klienta z ta sama konfiguracja.
+ * @param nip24 obiekt klienta
+ * @param key klucz odpowiedzi
+ * @param type typ numeru identyfikujacego firme
+ * @param number numer okreslonego typu
+ */
+static void _nip24_refresh(NIP24Client* nip24, const CacheKey* key, Number type, const char* number)
+{
+	RefreshTask* t = NULL;
+	HANDLE thread;
+
+	if (!cache_refresh_begin(nip24->cache, key)) {
+		return;
+	}
+
+	if ((t = (RefreshTask*)malloc(sizeof(RefreshTask))) == NULL) {
+		goto err;
+	}
+
+	memset(t, 0, sizeof(RefreshTask));
+
+	if (strlen(number) >= sizeof(t->number) || !client_clone(nip24, &t->nip24)) {
+		goto err;
+	}
+
+	memcpy(&t->key, key, sizeof(CacheKey));
+	t->type = type;
+	strcpy(t->number, number);
+
+	if ((thread = CreateThread(NULL, 0, _nip24_refresh_proc, t, 0, NULL)) == NULL) {
+		goto err;
+	}
+
+	CloseHandle(thread);
+
+	// ok
+	return;
+
+err:
+	if (t) {
+		nip24_free(&t->nip24);
+		free(t);
+	}
+
+	cache_refresh_end(nip24->cache, key);
+}
+
 /**
  * Pobranie wartosci elementu z dokumentu
  * @param doc obiekt dokumentu XML
@@ -774,84 +1091,725 @@ err:
 
 /////////////////////////////////////////////////////////////////
 
-NIP24_API BOOL nip24_new(NIP24Client** nip24, const char* url, const char* id, const char* key)
+/**
+ * Parsowanie ciagu XML (UTF-8) do dokumentu
+ * @param xml ciag XML
+ * @param doc adres na obiekt dokumentu XML
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+BOOL load_xml(const char* xml, IXMLDOMDocument2** doc)
 {
-	NIP24Client* n = NULL;
+	BSTR str = NULL;
 
 	BOOL ret = FALSE;
 
-	if (!nip24 || !url || strlen(url) == 0 || !id || strlen(id) == 0 || !key || strlen(key) == 0) {
+	if (!utf8_to_bstr(xml, &str)) {
 		goto err;
 	}
 
-	if ((n = (NIP24Client*)malloc(sizeof(NIP24Client))) == NULL) {
+	if (!_nip24_load_doc(str, doc)) {
 		goto err;
 	}
 
-	memset(n, 0, sizeof(NIP24Client));
-
-	n->url = strdup(url);
-	n->id = strdup(id);
-	n->key = strdup(key);
-
-	// ok
-	*nip24 = n;
-	n = NULL;
-
 	ret = TRUE;
 
 err:
-	nip24_free(&n);
+	SysFreeString(str);
 
 	return ret;
 }
 
-NIP24_API BOOL nip24_new_prod(NIP24Client** nip24, const char* id, const char* key)
+/**
+ * Dekodowanie odpowiedzi z danymi do faktury
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+InvoiceData* decode_invoice_data(IXMLDOMDocument2* doc)
 {
-	return nip24_new(nip24, NIP24_PRODUCTION_URL, id, key);
-}
+	InvoiceData* id = NULL;
 
-NIP24_API BOOL nip24_new_test(NIP24Client** nip24)
-{
-	return nip24_new(nip24, NIP24_TEST_URL, NIP24_TEST_ID, NIP24_TEST_KEY);
-}
+	if (!invoicedata_new(&id)) {
+		goto err;
+	}
 
-NIP24_API void nip24_free(NIP24Client** nip24)
-{
-	NIP24Client* n = (nip24 ? *nip24 : NULL);
+	id->UID = _nip24_parse_str(doc, L"/result/firm/uid", NULL);
 
-	if (n) {
-		free(n->url);
-		free(n->id);
-		free(n->key);
+	id->NIP = _nip24_parse_str(doc, L"/result/firm/nip", NULL);
 
-		free(n->app);
-		free(n->err);
+	id->Name = _nip24_parse_str(doc, L"/result/firm/name", NULL);
+	id->FirstName = _nip24_parse_str(doc, L"/result/firm/firstname", NULL);
+	id->LastName = _nip24_parse_str(doc, L"/result/firm/lastname", NULL);
 
-		free(*nip24);
-		*nip24 = NULL;
+	id->Street = _nip24_parse_str(doc, L"/result/firm/street", NULL);
+	id->StreetNumber = _nip24_parse_str(doc, L"/result/firm/streetNumber", NULL);
+	id->HouseNumber = _nip24_parse_str(doc, L"/result/firm/houseNumber", NULL);
+	id->City = _nip24_parse_str(doc, L"/result/firm/city", NULL);
+	id->PostCode = _nip24_parse_str(doc, L"/result/firm/postCode", NULL);
+	id->PostCity = _nip24_parse_str(doc, L"/result/firm/postCity", NULL);
+
+	id->Phone = _nip24_parse_str(doc, L"/result/firm/phone", NULL);
+	id->Email = _nip24_parse_str(doc, L"/result/firm/email", NULL);
+	id->WWW = _nip24_parse_str(doc, L"/result/firm/www", NULL);
+
+err:
+	return id;
+}
+
+/**
+ * Dekodowanie odpowiedzi z pelnymi danymi firmy
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+AllData* decode_all_data(IXMLDOMDocument2* doc)
+{
+	AllData* ad = NULL;
+	BusinessPartner* bp = NULL;
+	PKD* pkd = NULL;
+
+	wchar_t xpath[MAX_STRING];
+
+	char* str = NULL;
+
+	int i;
+
+	if (!alldata_new(&ad)) {
+		goto err;
+	}
+
+	ad->UID = _nip24_parse_str(doc, L"/result/firm/uid", NULL);
+
+	ad->Type = _nip24_parse_str(doc, L"/result/firm/type", NULL);
+	ad->NIP = _nip24_parse_str(doc, L"/result/firm/nip", NULL);
+	ad->REGON = _nip24_parse_str(doc, L"/result/firm/regon", NULL);
+
+	ad->Name = _nip24_parse_str(doc, L"/result/firm/name", NULL);
+	ad->ShortName = _nip24_parse_str(doc, L"/result/firm/shortname", NULL);
+	ad->FirstName = _nip24_parse_str(doc, L"/result/firm/firstname", NULL);
+	ad->SecondName = _nip24_parse_str(doc, L"/result/firm/secondname", NULL);
+	ad->LastName = _nip24_parse_str(doc, L"/result/firm/lastname", NULL);
+
+	ad->Street = _nip24_parse_str(doc, L"/result/firm/street", NULL);
+	ad->StreetCode = _nip24_parse_str(doc, L"/result/firm/streetCode", NULL);
+	ad->StreetNumber = _nip24_parse_str(doc, L"/result/firm/streetNumber", NULL);
+	ad->HouseNumber = _nip24_parse_str(doc, L"/result/firm/houseNumber", NULL);
+	ad->City = _nip24_parse_str(doc, L"/result/firm/city", NULL);
+	ad->CityCode = _nip24_parse_str(doc, L"/result/firm/cityCode", NULL);
+	ad->Community = _nip24_parse_str(doc, L"/result/firm/community", NULL);
+	ad->CommunityCode = _nip24_parse_str(doc, L"/result/firm/communityCode", NULL);
+	ad->County = _nip24_parse_str(doc, L"/result/firm/county", NULL);
+	ad->CountyCode = _nip24_parse_str(doc, L"/result/firm/countyCode", NULL);
+	ad->State = _nip24_parse_str(doc, L"/result/firm/state", NULL);
+	ad->StateCode = _nip24_parse_str(doc, L"/result/firm/stateCode", NULL);
+	ad->PostCode = _nip24_parse_str(doc, L"/result/firm/postCode", NULL);
+	ad->PostCity = _nip24_parse_str(doc, L"/result/firm/postCity", NULL);
+
+	ad->Phone = _nip24_parse_str(doc, L"/result/firm/phone", NULL);
+	ad->Email = _nip24_parse_str(doc, L"/result/firm/email", NULL);
+	ad->WWW = _nip24_parse_str(doc, L"/result/firm/www", NULL);
+
+	ad->CreationDate = _nip24_parse_datetime(doc, L"/result/firm/creationDate");
+	ad->StartDate = _nip24_parse_datetime(doc, L"/result/firm/startDate");
+	ad->RegistrationDate = _nip24_parse_datetime(doc, L"/result/firm/registrationDate");
+	ad->HoldDate = _nip24_parse_datetime(doc, L"/result/firm/holdDate");
+	ad->RenevalDate = _nip24_parse_datetime(doc, L"/result/firm/renevalDate");
+	ad->LastUpdateDate = _nip24_parse_datetime(doc, L"/result/firm/lastUpdateDate");
+	ad->BankruptcyDate = _nip24_parse_datetime(doc, L"/result/firm/bankruptcyDate");
+	ad->EndOfBankruptcyProceedingsDate = _nip24_parse_datetime(doc, L"/result/firm/endOfBankruptcyProceedingsDate");
+	ad->EndDate = _nip24_parse_datetime(doc, L"/result/firm/endDate");
+
+	ad->RegistryEntityCode = _nip24_parse_str(doc, L"/result/firm/registryEntity/code", NULL);
+	ad->RegistryEntityName = _nip24_parse_str(doc, L"/result/firm/registryEntity/name", NULL);
+
+	ad->RegistryCode = _nip24_parse_str(doc, L"/result/firm/registry/code", NULL);
+	ad->RegistryName = _nip24_parse_str(doc, L"/result/firm/registry/name", NULL);
+
+	ad->RecordCreationDate = _nip24_parse_datetime(doc, L"/result/firm/record/created");
+	ad->RecordNumber = _nip24_parse_str(doc, L"/result/firm/record/number", NULL);
+
+	ad->BasicLegalFormCode = _nip24_parse_str(doc, L"/result/firm/basicLegalForm/code", NULL);
+	ad->BasicLegalFormName = _nip24_parse_str(doc, L"/result/firm/basicLegalForm/name", NULL);
+
+	ad->SpecificLegalFormCode = _nip24_parse_str(doc, L"/result/firm/specificLegalForm/code", NULL);
+	ad->SpecificLegalFormName = _nip24_parse_str(doc, L"/result/firm/specificLegalForm/name", NULL);
+
+	ad->OwnershipFormCode = _nip24_parse_str(doc, L"/result/firm/ownershipForm/code", NULL);
+	ad->OwnershipFormName = _nip24_parse_str(doc, L"/result/firm/ownershipForm/name", NULL);
+
+	for (i = 1; ; i++) {
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/regon", i);
+		str = _nip24_parse_str(doc, xpath, NULL);
+
+		if (!str || strlen(str) == 0) {
+			break;
+		}
+
+		if (!businesspartner_new(&bp)) {
+			alldata_free(&ad);
+			goto err;
+		}
+
+		bp->REGON = str;
+		str = NULL;
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/firmName", i);
+		bp->FirmName = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/firstName", i);
+		bp->FirstName = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/secondName", i);
+		bp->SecondName = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/lastName", i);
+		bp->LastName = _nip24_parse_str(doc, xpath, NULL);
+
+		free(str);
+		str = NULL;
+
+		// add
+		ad->BusinessPartnerCount++;
+
+		if ((ad->BusinessPartner = (BusinessPartner**)realloc(ad->BusinessPartner, sizeof(BusinessPartner*) * ad->BusinessPartnerCount)) == NULL) {
+			alldata_free(&ad);
+			goto err;
+		}
+
+		ad->BusinessPartner[ad->BusinessPartnerCount - 1] = bp;
+		bp = NULL;
+	}
+
+	for (i = 1; ; i++) {
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/code", i);
+		str = _nip24_parse_str(doc, xpath, NULL);
+
+		if (!str || strlen(str) == 0) {
+			break;
+		}
+
+		if (!pkd_new(&pkd)) {
+			alldata_free(&ad);
+			goto err;
+		}
+
+		pkd->Code = str;
+		str = NULL;
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/description", i);
+		pkd->Description = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/primary", i);
+		str = _nip24_parse_str(doc, xpath, "false");
+		pkd->Primary = (strcmp(str, "true") == 0 ? TRUE : FALSE);
+		
+		free(str);
+		str = NULL;
+
+		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/version", i);
+		pkd->Version = _nip24_parse_str(doc, xpath, NULL);
+
+		// add
+		ad->PKDCount++;
+
+		if ((ad->PKD = (PKD**)realloc(ad->PKD, sizeof(PKD*) * ad->PKDCount)) == NULL) {
+			alldata_free(&ad);
+			goto err;
+		}
+		
+		ad->PKD[ad->PKDCount - 1] = pkd;
+		pkd = NULL;
+	}
+
+err:
+	businesspartner_free(&bp);
+	pkd_free(&pkd);
+
+	free(str);
+
+	return ad;
+}
+
+/**
+ * Dekodowanie odpowiedzi z danymi z systemu VIES
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+VIESData* decode_vies_data(IXMLDOMDocument2* doc)
+{
+	VIESData* vies = NULL;
+
+	if (!viesdata_new(&vies)) {
+		goto err;
+	}
+
+	vies->UID = _nip24_parse_str(doc, L"/result/vies/uid", NULL);
+
+	vies->CountryCode = _nip24_parse_str(doc, L"/result/vies/countryCode", NULL);
+	vies->VATNumber = _nip24_parse_str(doc, L"/result/vies/vatNumber", NULL);
+
+	vies->Valid = _nip24_parse_bool(doc, L"/result/vies/valid", FALSE);
+
+	vies->TraderName = _nip24_parse_str(doc, L"/result/vies/traderName", NULL);
+	vies->TraderCompanyType = _nip24_parse_str(doc, L"/result/vies/traderCompanyType", NULL);
+	vies->TraderAddress = _nip24_parse_str(doc, L"/result/vies/traderAddress", NULL);
+
+	vies->ID = _nip24_parse_str(doc, L"/result/vies/id", NULL);
+	vies->Date = _nip24_parse_date(doc, L"/result/vies/date");
+	vies->Source = _nip24_parse_str(doc, L"/result/vies/source", NULL);
+
+err:
+	return vies;
+}
+
+/**
+ * Dekodowanie odpowiedzi ze statusem VAT
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+VATStatus* decode_vat_status(IXMLDOMDocument2* doc)
+{
+	VATStatus* vat = NULL;
+
+	if (!vatstatus_new(&vat)) {
+		goto err;
+	}
+
+	vat->UID = _nip24_parse_str(doc, L"/result/vat/uid", NULL);
+
+	vat->NIP = _nip24_parse_str(doc, L"/result/vat/nip", NULL);
+	vat->REGON = _nip24_parse_str(doc, L"/result/vat/regon", NULL);
+	vat->Name = _nip24_parse_str(doc, L"/result/vat/name", NULL);
+
+	vat->Status = _nip24_parse_int(doc, L"/result/vat/status", 0);
+	vat->Result = _nip24_parse_str(doc, L"/result/vat/result", NULL);
+
+	vat->ID = _nip24_parse_str(doc, L"/result/vat/id", NULL);
+	vat->Date = _nip24_parse_date(doc, L"/result/vat/date");
+	vat->Source = _nip24_parse_str(doc, L"/result/vat/source", NULL);
+
+err:
+	return vat;
+}
+
+/**
+ * Dekodowanie odpowiedzi ze statusem rachunku bankowego
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+IBANStatus* decode_iban_status(IXMLDOMDocument2* doc)
+{
+	IBANStatus* is = NULL;
+
+	if (!ibanstatus_new(&is)) {
+		goto err;
+	}
+
+	is->UID = _nip24_parse_str(doc, L"/result/iban/uid", NULL);
+
+	is->NIP = _nip24_parse_str(doc, L"/result/iban/nip", NULL);
+	is->REGON = _nip24_parse_str(doc, L"/result/iban/regon", NULL);
+	is->IBAN = _nip24_parse_str(doc, L"/result/iban/iban", NULL);
+
+	is->Valid = _nip24_parse_bool(doc, L"/result/iban/valid", FALSE);
+	
+	is->ID = _nip24_parse_str(doc, L"/result/iban/id", NULL);
+	is->Date = _nip24_parse_date(doc, L"/result/iban/date");
+	is->Source = _nip24_parse_str(doc, L"/result/iban/source", NULL);
+
+err:
+	return is;
+}
+
+/**
+ * Dekodowanie odpowiedzi ze statusem na bialej liscie VAT
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+WLStatus* decode_whitelist_status(IXMLDOMDocument2* doc)
+{
+	WLStatus* ws = NULL;
+
+	if (!wlstatus_new(&ws)) {
+		goto err;
+	}
+
+	ws->UID = _nip24_parse_str(doc, L"/result/whitelist/uid", NULL);
+
+	ws->NIP = _nip24_parse_str(doc, L"/result/whitelist/nip", NULL);
+	ws->IBAN = _nip24_parse_str(doc, L"/result/whitelist/iban", NULL);
+
+	ws->Valid = _nip24_parse_bool(doc, L"/result/whitelist/valid", FALSE);
+	ws->Virtual = _nip24_parse_bool(doc, L"/result/whitelist/virtual", FALSE);
+
+	ws->Status = _nip24_parse_int(doc, L"/result/whitelist/vatStatus", 0);
+	ws->Result = _nip24_parse_str(doc, L"/result/whitelist/vatResult", NULL);
+
+	ws->HashIndex = _nip24_parse_int(doc, L"/result/whitelist/hashIndex", -1);
+	ws->MaskIndex = _nip24_parse_int(doc, L"/result/whitelist/maskIndex", -1);
+	ws->Date = _nip24_parse_date(doc, L"/result/whitelist/date");
+	ws->Source = _nip24_parse_str(doc, L"/result/whitelist/source", NULL);
+
+err:
+	return ws;
+}
+
+/**
+ * Dekodowanie odpowiedzi z wynikami wyszukiwania w rejestrze VAT
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+SearchResult* decode_search_result(IXMLDOMDocument2* doc)
+{
+	SearchResult* sr = NULL;
+	VATEntity* ve = NULL;
+
+	wchar_t xpath[MAX_STRING];
+
+	char* str = NULL;
+
+	int i;
+	int k;
+
+	if (!searchresult_new(&sr)) {
+		goto err;
+	}
+
+	sr->UID = _nip24_parse_str(doc, L"/result/search/uid", NULL);
+	sr->ResultsType = NIP24_RESULT_VAT_ENTITY;
+
+	for (i = 1; ; i++) {
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/nip", i);
+		str = _nip24_parse_str(doc, xpath, NULL);
+
+		if (!str || strlen(str) == 0) {
+			break;
+		}
+
+		if (!vatentity_new(&ve)) {
+			searchresult_free(&sr);
+			goto err;
+		}
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/name", i);
+		ve->Name = _nip24_parse_str(doc, xpath, NULL);
+
+		ve->NIP = str;
+		str = NULL;
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/regon", i);
+		ve->REGON = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/krs", i);
+		ve->KRS = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/residenceAddress", i);
+		ve->ResidenceAddress = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/workingAddress", i);
+		ve->WorkingAddress = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/vat/status", i);
+		ve->VATStatus = _nip24_parse_int(doc, xpath, 0);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/vat/result", i);
+		ve->VATResult = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/representatives", i);
+		_nip24_parse_vatperson(doc, xpath, &ve->Representatives, &ve->RepresentativesCount);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/authorizedClerks", i);
+		_nip24_parse_vatperson(doc, xpath, &ve->AuthorizedClerks, &ve->AuthorizedClerksCount);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/partners", i);
+		_nip24_parse_vatperson(doc, xpath, &ve->Partners, &ve->PartnersCount);
+
+		for (k = 1; ; k++) {
+			_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/ibans/iban[%d]", i, k);
+			str = _nip24_parse_str(doc, xpath, NULL);
+
+			if (!str || strlen(str) == 0) {
+				break;
+			}
+
+			// add
+			ve->IBANsCount++;
+
+			if ((ve->IBANs = (char**)realloc(ve->IBANs, sizeof(char*) * ve->IBANsCount)) == NULL) {
+				searchresult_free(&sr);
+				goto err;
+			}
+
+			ve->IBANs[ve->IBANsCount - 1] = str;
+			str = NULL;
+		}
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/hasVirtualAccounts", i);
+		str = _nip24_parse_str(doc, xpath, "false");
+		ve->HasVirtualAccounts = (strcmp(str, "true") == 0 ? TRUE : FALSE);
+
+		free(str);
+		str = NULL;
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationLegalDate", i);
+		ve->RegistrationLegalDate = _nip24_parse_date(doc, xpath);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationDenialDate", i);
+		ve->RegistrationDenialDate = _nip24_parse_date(doc, xpath);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationDenialBasis", i);
+		ve->RegistrationDenialBasis = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/restorationDate", i);
+		ve->RestorationDate = _nip24_parse_date(doc, xpath);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/restorationBasis", i);
+		ve->RestorationBasis = _nip24_parse_str(doc, xpath, NULL);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/removalDate", i);
+		ve->RemovalDate = _nip24_parse_date(doc, xpath);
+
+		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/removalBasis", i);
+		ve->RemovalBasis = _nip24_parse_str(doc, xpath, NULL);
+
+		// add
+		sr->ResultsCount++;
+
+		if ((sr->Results.VATEntity = (VATEntity**)realloc(sr->Results.VATEntity, sizeof(VATEntity*) * sr->ResultsCount)) == NULL) {
+			searchresult_free(&sr);
+			goto err;
+		}
+
+		sr->Results.VATEntity[sr->ResultsCount - 1] = ve;
+		ve = NULL;
+	}
+
+	sr->ID = _nip24_parse_str(doc, L"/result/search/id", NULL);
+	sr->Date = _nip24_parse_date(doc, L"/result/search/date");
+	sr->Source = _nip24_parse_str(doc, L"/result/search/source", NULL);
+
+err:
+	vatentity_free(&ve);
+
+	free(str);
+
+	return sr;
+}
+
+/**
+ * Dekodowanie odpowiedzi ze statusem konta
+ * @param doc dokument XML z odpowiedzia serwera
+ * @return obiekt z danymi lub NULL w przypadku bledu
+ */
+AccountStatus* decode_account_status(IXMLDOMDocument2* doc)
+{
+	AccountStatus* status = NULL;
+
+	if (!accountstatus_new(&status)) {
+		goto err;
+	}
+
+	status->UID = _nip24_parse_str(doc, L"/result/account/uid", NULL);
+	status->Type = _nip24_parse_str(doc, L"/result/account/type", NULL);
+	status->ValidTo = _nip24_parse_datetime(doc, L"/result/account/validTo");
+	status->BillingPlanName = _nip24_parse_str(doc, L"/result/account/billingPlan/name", NULL);
+
+	status->SubscriptionPrice = _nip24_parse_double(doc, L"/result/account/billingPlan/subscriptionPrice", 0);
+	status->ItemPrice = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPrice", 0);
+	status->ItemPriceStatus = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceCheckStatus", 0);
+	status->ItemPriceInvoice = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceInvoiceData", 0);
+	status->ItemPriceAll = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceAllData", 0);
+	status->ItemPriceIBAN = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceAllIBAN", 0);
+	status->ItemPriceWhitelist = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceWLStatus", 0);
+	status->ItemPriceSearchVAT = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceSearchVAT", 0);
+
+	status->Limit = _nip24_parse_int(doc, L"/result/account/billingPlan/limit", 0);
+	status->RequestDelay = _nip24_parse_int(doc, L"/result/account/billingPlan/requestDelay", 0);
+	status->DomainLimit = _nip24_parse_int(doc, L"/result/account/billingPlan/domainLimit", 0);
+
+	status->OverPlanAllowed = _nip24_parse_bool(doc, L"/result/account/billingPlan/overplanAllowed", FALSE);
+	status->TerytCodes = _nip24_parse_bool(doc, L"/result/account/billingPlan/terytCodes", FALSE);
+	status->ExcelAddIn = _nip24_parse_bool(doc, L"/result/account/billingPlan/excelAddin", FALSE);
+	status->JPKVAT = _nip24_parse_bool(doc, L"/result/account/billingPlan/jpkVat", FALSE);
+	status->CLI = _nip24_parse_bool(doc, L"/result/account/billingPlan/cli", FALSE);
+	status->Stats = _nip24_parse_bool(doc, L"/result/account/billingPlan/stats", FALSE);
+	status->NIPMonitor = _nip24_parse_bool(doc, L"/result/account/billingPlan/nipMonitor", FALSE);
+
+	status->SearchByNIP = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByNip", FALSE);
+	status->SearchByREGON = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByRegon", FALSE);
+	status->SearchByKRS = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByKrs", FALSE);
+
+	status->FuncIsActive = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcIsActive", FALSE);
+	status->FuncGetInvoiceData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetInvoiceData", FALSE);
+	status->FuncGetAllData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetAllData", FALSE);
+	status->FuncGetVIESData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetVIESData", FALSE);
+	status->FuncGetVATStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetVATStatus", FALSE);
+	status->FuncGetIBANStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetIBANStatus", FALSE);
+	status->FuncGetWhitelistStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetWLStatus", FALSE);
+	status->FuncSearchVAT = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcSearchVAT", FALSE);
+
+	status->InvoiceDataCount = _nip24_parse_int(doc, L"/result/account/requests/invoiceData", 0);
+	status->AllDataCount = _nip24_parse_int(doc, L"/result/account/requests/allData", 0);
+	status->FirmStatusCount = _nip24_parse_int(doc, L"/result/account/requests/firmStatus", 0);
+	status->VATStatusCount = _nip24_parse_int(doc, L"/result/account/requests/vatStatus", 0);
+	status->VIESStatusCount = _nip24_parse_int(doc, L"/result/account/requests/viesStatus", 0);
+	status->IBANStatusCount = _nip24_parse_int(doc, L"/result/account/requests/ibanStatus", 0);
+	status->WhitelistStatusCount = _nip24_parse_int(doc, L"/result/account/requests/wlStatus", 0);
+	status->SearchVATCount = _nip24_parse_int(doc, L"/result/account/requests/searchVAT", 0);
+	status->TotalCount = _nip24_parse_int(doc, L"/result/account/requests/total", 0);
+
+err:
+	return status;
+}
+
+/**
+ * Utworzenie obiektu klienta z taka sama konfiguracja (do uzycia w innym watku)
+ * @param nip24 obiekt klienta
+ * @param copy adres na utworzony obiekt klienta
+ * @return TRUE jezeli OK, FALSE w przypadku bledu
+ */
+BOOL client_clone(NIP24Client* nip24, NIP24Client** copy)
+{
+	NIP24Client* n = NULL;
+
+	BOOL ret = FALSE;
+
+	if (!nip24_new(&n, nip24->url, nip24->id, nip24->key)) {
+		goto err;
+	}
+
+	if (nip24->app && (n->app = strdup(nip24->app)) == NULL) {
+		goto err;
+	}
+
+	n->cache = nip24->cache;
+
+	// ok
+	*copy = n;
+	n = NULL;
+
+	ret = TRUE;
+
+err:
+	nip24_free(&n);
+
+	return ret;
+}
+
+NIP24_API BOOL nip24_new(NIP24Client** nip24, const char* url, const char* id, const char* key)
+{
+	NIP24Client* n = NULL;
+
+	BOOL ret = FALSE;
+
+	if (!nip24 || !url || strlen(url) == 0 || !id || strlen(id) == 0 || !key || strlen(key) == 0) {
+		goto err;
+	}
+
+	if ((n = (NIP24Client*)malloc(sizeof(NIP24Client))) == NULL) {
+		goto err;
+	}
+
+	memset(n, 0, sizeof(NIP24Client));
+
+	InitializeCriticalSection(&n->lock);
+
+	if ((n->tls = TlsAlloc()) == TLS_OUT_OF_INDEXES) {
+		goto err;
+	}
+
+	n->url = strdup(url);
+	n->id = strdup(id);
+	n->key = strdup(key);
+
+	// ok
+	*nip24 = n;
+	n = NULL;
+
+	ret = TRUE;
+
+err:
+	nip24_free(&n);
+
+	return ret;
+}
+
+NIP24_API BOOL nip24_new_prod(NIP24Client** nip24, const char* id, const char* key)
+{
+	return nip24_new(nip24, NIP24_PRODUCTION_URL, id, key);
+}
+
+NIP24_API BOOL nip24_new_test(NIP24Client** nip24)
+{
+	return nip24_new(nip24, NIP24_TEST_URL, NIP24_TEST_ID, NIP24_TEST_KEY);
+}
+
+NIP24_API void nip24_free(NIP24Client** nip24)
+{
+	NIP24Client* n = (nip24 ? *nip24 : NULL);
+
+	struct NIP24ClientError* e;
+	struct NIP24ClientError* next;
+
+	if (n) {
+		free(n->url);
+		free(n->id);
+		free(n->key);
+
+		free(n->app);
+
+		for (e = n->errors; e; e = next) {
+			next = e->next;
+
+			free(e->err);
+			free(e);
+		}
+
+		if (n->tls != TLS_OUT_OF_INDEXES) {
+			TlsFree(n->tls);
+		}
+
+		DeleteCriticalSection(&n->lock);
+
+		free(*nip24);
+		*nip24 = NULL;
 	}
 }
 
 NIP24_API int nip24_get_last_err_code(NIP24Client* nip24)
 {
-	return (nip24 ? nip24->err_code : -1);
+	struct NIP24ClientError* e;
+
+	if (!nip24) {
+		return -1;
+	}
+
+	return ((e = _nip24_get_err(nip24)) != NULL ? e->code : NIP24_ERR_CLI_EXCEPTION);
 }
 
 NIP24_API char* nip24_get_last_err(NIP24Client* nip24)
 {
-	return (nip24 ? nip24->err : NULL);
+	struct NIP24ClientError* e;
+
+	if (!nip24 || (e = _nip24_get_err(nip24)) == NULL) {
+		return NULL;
+	}
+
+	return e->err;
 }
 
 NIP24_API BOOL nip24_is_active(NIP24Client* nip24, Number type, const char* number)
 {
 	IXMLDOMDocument2* doc = NULL;
+	CacheKey ck;
 
 	BOOL ret = FALSE;
 
 	char url[MAX_STRING];
 
 	char* code = NULL;
+	char* err = NULL;
+	int err_code;
+
+	BOOL cached;
 
 	if (!nip24 || type < NIP || type > EUVAT || !number || strlen(number) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
@@ -861,6 +1819,22 @@ NIP24_API BOOL nip24_is_active(NIP24Client* nip24, Number type, const char* numb
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna (tylko odpowiedzi negatywne)
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_ACTIVE, type, number, NULL, 0, &ck);
+
+	if (cached) {
+		cache_get(nip24->cache, &ck, &err_code, &err, NULL);
+
+		if (err_code == NIP24_ERR_NIP_NOT_ACTIVE) {
+			// not active
+			goto err;
+		}
+		else if (err_code != 0) {
+			_nip24_set_err(nip24, err_code, err);
+			goto err;
+		}
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/check/firm/", nip24->url);
 
@@ -878,14 +1852,17 @@ NIP24_API BOOL nip24_is_active(NIP24Client* nip24, Number type, const char* numb
 	code = _nip24_parse_str(doc, L"/result/error/code", NULL);
 
 	if (code && strlen(code) > 0) {
-		if (strcmp(code, "9") == 0) {
+		// error
+		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
+
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
+
+		if (nip24_get_last_err_code(nip24) == NIP24_ERR_NIP_NOT_ACTIVE) {
 			// not active
 			_nip24_clear_err(nip24);
 		}
-		else {
-			// error
-			_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		}
 
 		goto err;
 	}
@@ -899,6 +1876,7 @@ err:
 	}
 
 	free(code);
+	free(err);
 
 	return ret;
 }
@@ -912,11 +1890,16 @@ NIP24_API InvoiceData* nip24_get_invoice_data(NIP24Client* nip24, Number type, c
 {
 	IXMLDOMDocument2* doc = NULL;
 	InvoiceData* id = NULL;
+	CacheKey ck;
+	CacheKey dk;
 
 	char url[MAX_STRING];
 
 	char* code = NULL;
 
+	BOOL cached;
+	BOOL stale;
+
 	if (!nip24 || type < NIP || type > EUVAT || !number || strlen(number) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
 		goto err;
@@ -925,6 +1908,24 @@ NIP24_API InvoiceData* nip24_get_invoice_data(NIP24Client* nip24, Number type, c
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_INVOICE, type, number, NULL, 0, &ck);
+
+	if (cached && !force && _nip24_cache_get(nip24, &ck, &stale, (void**)&id)) {
+		if (id && stale) {
+			id->Stale = TRUE;
+			_nip24_refresh(nip24, &ck, type, number);
+		}
+
+		goto err;
+	}
+
+	// dane wyznaczone z zapamietanych pelnych danych firmy
+	if (cached && !force && _nip24_cache_key(nip24, NIP24_ENDPOINT_ALL, type, number, NULL, 0, &dk)
+		&& (id = derive_invoice_data(nip24->cache, &dk)) != NULL) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/get/invoice/", nip24->url);
 
@@ -944,31 +1945,19 @@ NIP24_API InvoiceData* nip24_get_invoice_data(NIP24Client* nip24, Number type, c
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
 
-	if (!invoicedata_new(&id)) {
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
+
 		goto err;
 	}
 
-	id->UID = _nip24_parse_str(doc, L"/result/firm/uid", NULL);
-
-	id->NIP = _nip24_parse_str(doc, L"/result/firm/nip", NULL);
-
-	id->Name = _nip24_parse_str(doc, L"/result/firm/name", NULL);
-	id->FirstName = _nip24_parse_str(doc, L"/result/firm/firstname", NULL);
-	id->LastName = _nip24_parse_str(doc, L"/result/firm/lastname", NULL);
-
-	id->Street = _nip24_parse_str(doc, L"/result/firm/street", NULL);
-	id->StreetNumber = _nip24_parse_str(doc, L"/result/firm/streetNumber", NULL);
-	id->HouseNumber = _nip24_parse_str(doc, L"/result/firm/houseNumber", NULL);
-	id->City = _nip24_parse_str(doc, L"/result/firm/city", NULL);
-	id->PostCode = _nip24_parse_str(doc, L"/result/firm/postCode", NULL);
-	id->PostCity = _nip24_parse_str(doc, L"/result/firm/postCity", NULL);
+	id = decode_invoice_data(doc);
 
-	id->Phone = _nip24_parse_str(doc, L"/result/firm/phone", NULL);
-	id->Email = _nip24_parse_str(doc, L"/result/firm/email", NULL);
-	id->WWW = _nip24_parse_str(doc, L"/result/firm/www", NULL);
+	if (id && cached) {
+		cache_put(nip24->cache, &ck, id);
+	}
 
 err:
 	if (doc) {
@@ -989,16 +1978,13 @@ NIP24_API AllData* nip24_get_all_data(NIP24Client* nip24, Number type, const cha
 {
 	IXMLDOMDocument2* doc = NULL;
 	AllData* ad = NULL;
-	BusinessPartner* bp = NULL;
-	PKD* pkd = NULL;
+	CacheKey ck;
 
-	wchar_t xpath[MAX_STRING];
 	char url[MAX_STRING];
 
 	char* code = NULL;
-	char* str = NULL;
 
-	int i;
+	BOOL cached;
 
 	if (!nip24 || type < NIP || type > EUVAT || !number || strlen(number) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
@@ -1008,6 +1994,13 @@ NIP24_API AllData* nip24_get_all_data(NIP24Client* nip24, Number type, const cha
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_ALL, type, number, NULL, 0, &ck);
+
+	if (cached && !force && _nip24_cache_get(nip24, &ck, NULL, (void**)&ad)) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/get/all/", nip24->url);
 
@@ -1027,154 +2020,18 @@ NIP24_API AllData* nip24_get_all_data(NIP24Client* nip24, Number type, const cha
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
-
-	if (!alldata_new(&ad)) {
-		goto err;
-	}
-
-	ad->UID = _nip24_parse_str(doc, L"/result/firm/uid", NULL);
-
-	ad->Type = _nip24_parse_str(doc, L"/result/firm/type", NULL);
-	ad->NIP = _nip24_parse_str(doc, L"/result/firm/nip", NULL);
-	ad->REGON = _nip24_parse_str(doc, L"/result/firm/regon", NULL);
-
-	ad->Name = _nip24_parse_str(doc, L"/result/firm/name", NULL);
-	ad->ShortName = _nip24_parse_str(doc, L"/result/firm/shortname", NULL);
-	ad->FirstName = _nip24_parse_str(doc, L"/result/firm/firstname", NULL);
-	ad->SecondName = _nip24_parse_str(doc, L"/result/firm/secondname", NULL);
-	ad->LastName = _nip24_parse_str(doc, L"/result/firm/lastname", NULL);
-
-	ad->Street = _nip24_parse_str(doc, L"/result/firm/street", NULL);
-	ad->StreetCode = _nip24_parse_str(doc, L"/result/firm/streetCode", NULL);
-	ad->StreetNumber = _nip24_parse_str(doc, L"/result/firm/streetNumber", NULL);
-	ad->HouseNumber = _nip24_parse_str(doc, L"/result/firm/houseNumber", NULL);
-	ad->City = _nip24_parse_str(doc, L"/result/firm/city", NULL);
-	ad->CityCode = _nip24_parse_str(doc, L"/result/firm/cityCode", NULL);
-	ad->Community = _nip24_parse_str(doc, L"/result/firm/community", NULL);
-	ad->CommunityCode = _nip24_parse_str(doc, L"/result/firm/communityCode", NULL);
-	ad->County = _nip24_parse_str(doc, L"/result/firm/county", NULL);
-	ad->CountyCode = _nip24_parse_str(doc, L"/result/firm/countyCode", NULL);
-	ad->State = _nip24_parse_str(doc, L"/result/firm/state", NULL);
-	ad->StateCode = _nip24_parse_str(doc, L"/result/firm/stateCode", NULL);
-	ad->PostCode = _nip24_parse_str(doc, L"/result/firm/postCode", NULL);
-	ad->PostCity = _nip24_parse_str(doc, L"/result/firm/postCity", NULL);
-
-	ad->Phone = _nip24_parse_str(doc, L"/result/firm/phone", NULL);
-	ad->Email = _nip24_parse_str(doc, L"/result/firm/email", NULL);
-	ad->WWW = _nip24_parse_str(doc, L"/result/firm/www", NULL);
-
-	ad->CreationDate = _nip24_parse_datetime(doc, L"/result/firm/creationDate");
-	ad->StartDate = _nip24_parse_datetime(doc, L"/result/firm/startDate");
-	ad->RegistrationDate = _nip24_parse_datetime(doc, L"/result/firm/registrationDate");
-	ad->HoldDate = _nip24_parse_datetime(doc, L"/result/firm/holdDate");
-	ad->RenevalDate = _nip24_parse_datetime(doc, L"/result/firm/renevalDate");
-	ad->LastUpdateDate = _nip24_parse_datetime(doc, L"/result/firm/lastUpdateDate");
-	ad->BankruptcyDate = _nip24_parse_datetime(doc, L"/result/firm/bankruptcyDate");
-	ad->EndOfBankruptcyProceedingsDate = _nip24_parse_datetime(doc, L"/result/firm/endOfBankruptcyProceedingsDate");
-	ad->EndDate = _nip24_parse_datetime(doc, L"/result/firm/endDate");
-
-	ad->RegistryEntityCode = _nip24_parse_str(doc, L"/result/firm/registryEntity/code", NULL);
-	ad->RegistryEntityName = _nip24_parse_str(doc, L"/result/firm/registryEntity/name", NULL);
-
-	ad->RegistryCode = _nip24_parse_str(doc, L"/result/firm/registry/code", NULL);
-	ad->RegistryName = _nip24_parse_str(doc, L"/result/firm/registry/name", NULL);
-
-	ad->RecordCreationDate = _nip24_parse_datetime(doc, L"/result/firm/record/created");
-	ad->RecordNumber = _nip24_parse_str(doc, L"/result/firm/record/number", NULL);
-
-	ad->BasicLegalFormCode = _nip24_parse_str(doc, L"/result/firm/basicLegalForm/code", NULL);
-	ad->BasicLegalFormName = _nip24_parse_str(doc, L"/result/firm/basicLegalForm/name", NULL);
 
-	ad->SpecificLegalFormCode = _nip24_parse_str(doc, L"/result/firm/specificLegalForm/code", NULL);
-	ad->SpecificLegalFormName = _nip24_parse_str(doc, L"/result/firm/specificLegalForm/name", NULL);
-
-	ad->OwnershipFormCode = _nip24_parse_str(doc, L"/result/firm/ownershipForm/code", NULL);
-	ad->OwnershipFormName = _nip24_parse_str(doc, L"/result/firm/ownershipForm/name", NULL);
-
-	for (i = 1; ; i++) {
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/regon", i);
-		str = _nip24_parse_str(doc, xpath, NULL);
-
-		if (!str || strlen(str) == 0) {
-			break;
-		}
-
-		if (!businesspartner_new(&bp)) {
-			alldata_free(&ad);
-			goto err;
-		}
-
-		bp->REGON = str;
-		str = NULL;
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/firmName", i);
-		bp->FirmName = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/firstName", i);
-		bp->FirstName = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/secondName", i);
-		bp->SecondName = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/businessPartners/businessPartner[%d]/lastName", i);
-		bp->LastName = _nip24_parse_str(doc, xpath, NULL);
-
-		free(str);
-		str = NULL;
-
-		// add
-		ad->BusinessPartnerCount++;
-
-		if ((ad->BusinessPartner = (BusinessPartner**)realloc(ad->BusinessPartner, sizeof(BusinessPartner*) * ad->BusinessPartnerCount)) == NULL) {
-			alldata_free(&ad);
-			goto err;
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
 		}
 
-		ad->BusinessPartner[ad->BusinessPartnerCount - 1] = bp;
-		bp = NULL;
+		goto err;
 	}
 
-	for (i = 1; ; i++) {
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/code", i);
-		str = _nip24_parse_str(doc, xpath, NULL);
-
-		if (!str || strlen(str) == 0) {
-			break;
-		}
-
-		if (!pkd_new(&pkd)) {
-			alldata_free(&ad);
-			goto err;
-		}
-
-		pkd->Code = str;
-		str = NULL;
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/description", i);
-		pkd->Description = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/primary", i);
-		str = _nip24_parse_str(doc, xpath, "false");
-		pkd->Primary = (strcmp(str, "true") == 0 ? TRUE : FALSE);
-		
-		free(str);
-		str = NULL;
-
-		_snwprintf(xpath, MAX_STRING, L"/result/firm/PKDs/PKD[%d]/version", i);
-		pkd->Version = _nip24_parse_str(doc, xpath, NULL);
-
-		// add
-		ad->PKDCount++;
+	ad = decode_all_data(doc);
 
-		if ((ad->PKD = (PKD**)realloc(ad->PKD, sizeof(PKD*) * ad->PKDCount)) == NULL) {
-			alldata_free(&ad);
-			goto err;
-		}
-		
-		ad->PKD[ad->PKDCount - 1] = pkd;
-		pkd = NULL;
+	if (ad && cached) {
+		cache_put(nip24->cache, &ck, ad);
 	}
 
 err:
@@ -1182,11 +2039,7 @@ err:
 		doc->lpVtbl->Release(doc);
 	}
 
-	businesspartner_free(&bp);
-	pkd_free(&pkd);
-
 	free(code);
-	free(str);
 
 	return ad;
 }
@@ -1200,11 +2053,14 @@ NIP24_API VIESData* nip24_get_vies_data(NIP24Client* nip24, const char* euvat)
 {
 	IXMLDOMDocument2* doc = NULL;
 	VIESData* vies = NULL;
+	CacheKey ck;
 
 	char url[MAX_STRING];
 
 	char* code = NULL;
 
+	BOOL cached;
+
 	if (!nip24 || !euvat || strlen(euvat) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
 		goto err;
@@ -1213,6 +2069,13 @@ NIP24_API VIESData* nip24_get_vies_data(NIP24Client* nip24, const char* euvat)
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_VIES, EUVAT, euvat, NULL, 0, &ck);
+
+	if (cached && _nip24_cache_get(nip24, &ck, NULL, (void**)&vies)) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/get/vies/", nip24->url);
 
@@ -1232,27 +2095,19 @@ NIP24_API VIESData* nip24_get_vies_data(NIP24Client* nip24, const char* euvat)
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
 
-	if (!viesdata_new(&vies)) {
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
+
 		goto err;
 	}
 
-	vies->UID = _nip24_parse_str(doc, L"/result/vies/uid", NULL);
-
-	vies->CountryCode = _nip24_parse_str(doc, L"/result/vies/countryCode", NULL);
-	vies->VATNumber = _nip24_parse_str(doc, L"/result/vies/vatNumber", NULL);
-
-	vies->Valid = _nip24_parse_bool(doc, L"/result/vies/valid", FALSE);
-
-	vies->TraderName = _nip24_parse_str(doc, L"/result/vies/traderName", NULL);
-	vies->TraderCompanyType = _nip24_parse_str(doc, L"/result/vies/traderCompanyType", NULL);
-	vies->TraderAddress = _nip24_parse_str(doc, L"/result/vies/traderAddress", NULL);
+	vies = decode_vies_data(doc);
 
-	vies->ID = _nip24_parse_str(doc, L"/result/vies/id", NULL);
-	vies->Date = _nip24_parse_date(doc, L"/result/vies/date");
-	vies->Source = _nip24_parse_str(doc, L"/result/vies/source", NULL);
+	if (vies && cached) {
+		cache_put(nip24->cache, &ck, vies);
+	}
 
 err:
 	if (doc) {
@@ -1268,11 +2123,15 @@ NIP24_API VATStatus* nip24_get_vat_status(NIP24Client* nip24, Number type, const
 {
 	IXMLDOMDocument2* doc = NULL;
 	VATStatus* vat = NULL;
+	CacheKey ck;
+	CacheKey dk;
 
 	char url[MAX_STRING];
 
 	char* code = NULL;
 
+	BOOL cached;
+
 	if (!nip24 || type < NIP || type > EUVAT || !number || strlen(number) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
 		goto err;
@@ -1281,6 +2140,19 @@ NIP24_API VATStatus* nip24_get_vat_status(NIP24Client* nip24, Number type, const
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_VAT, type, number, NULL, 0, &ck);
+
+	if (cached && !direct && _nip24_cache_get(nip24, &ck, NULL, (void**)&vat)) {
+		goto err;
+	}
+
+	// status wyznaczony z zapamietanego dzisiejszego wyniku wyszukiwania w rejestrze VAT
+	if (cached && !direct && _nip24_cache_key(nip24, NIP24_ENDPOINT_SEARCH, type, number, NULL, time(NULL), &dk)
+		&& (vat = derive_vat_status(nip24->cache, &dk)) != NULL) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/check/vat/direct/", nip24->url);
 
@@ -1300,25 +2172,19 @@ NIP24_API VATStatus* nip24_get_vat_status(NIP24Client* nip24, Number type, const
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
-
-	if (!vatstatus_new(&vat)) {
-		goto err;
-	}
 
-	vat->UID = _nip24_parse_str(doc, L"/result/vat/uid", NULL);
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
 
-	vat->NIP = _nip24_parse_str(doc, L"/result/vat/nip", NULL);
-	vat->REGON = _nip24_parse_str(doc, L"/result/vat/regon", NULL);
-	vat->Name = _nip24_parse_str(doc, L"/result/vat/name", NULL);
+		goto err;
+	}
 
-	vat->Status = _nip24_parse_int(doc, L"/result/vat/status", 0);
-	vat->Result = _nip24_parse_str(doc, L"/result/vat/result", NULL);
+	vat = decode_vat_status(doc);
 
-	vat->ID = _nip24_parse_str(doc, L"/result/vat/id", NULL);
-	vat->Date = _nip24_parse_date(doc, L"/result/vat/date");
-	vat->Source = _nip24_parse_str(doc, L"/result/vat/source", NULL);
+	if (vat && cached) {
+		cache_put(nip24->cache, &ck, vat);
+	}
 
 err:
 	if (doc) {
@@ -1339,32 +2205,26 @@ NIP24_API IBANStatus* nip24_get_iban_status(NIP24Client* nip24, Number type, con
 {
 	IXMLDOMDocument2* doc = NULL;
 	IBANStatus* is = NULL;
+	CacheKey ck;
 
-	char iban_str[MAX_STRING];
 	char date_str[MAX_STRING];
 	char url[MAX_STRING];
+	char ib[MAX_NUMBER];
 
 	char* code = NULL;
-	char* ib = NULL;
+
+	BOOL cached;
 
 	if (!nip24 || type < NIP || type > KRS || !number || strlen(number) == 0 || !iban || strlen(iban) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
 		goto err;
 	}
 
-	snprintf(iban_str, sizeof(iban_str), "%s", iban);
-
-	if (!nip24_iban_is_valid(iban_str)) {
-		snprintf(iban_str, sizeof(iban_str), "PL%s", iban);
-	
-		if (!nip24_iban_is_valid(iban_str)) {
-			_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
-			goto err;
-		}
+	if (!_nip24_check_iban(iban, ib, sizeof(ib))) {
+		_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
+		goto err;
 	}
 
-	ib = nip24_iban_normalize(iban_str);
-
 	if (date <= 0) {
 		date = time(NULL);
 	}
@@ -1374,6 +2234,13 @@ NIP24_API IBANStatus* nip24_get_iban_status(NIP24Client* nip24, Number type, con
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_IBAN, type, number, ib, date, &ck);
+
+	if (cached && _nip24_cache_get(nip24, &ck, NULL, (void**)&is)) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/check/iban/", nip24->url);
 
@@ -1398,24 +2265,19 @@ NIP24_API IBANStatus* nip24_get_iban_status(NIP24Client* nip24, Number type, con
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
 
-	if (!ibanstatus_new(&is)) {
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
+
 		goto err;
 	}
 
-	is->UID = _nip24_parse_str(doc, L"/result/iban/uid", NULL);
-
-	is->NIP = _nip24_parse_str(doc, L"/result/iban/nip", NULL);
-	is->REGON = _nip24_parse_str(doc, L"/result/iban/regon", NULL);
-	is->IBAN = _nip24_parse_str(doc, L"/result/iban/iban", NULL);
+	is = decode_iban_status(doc);
 
-	is->Valid = _nip24_parse_bool(doc, L"/result/iban/valid", FALSE);
-	
-	is->ID = _nip24_parse_str(doc, L"/result/iban/id", NULL);
-	is->Date = _nip24_parse_date(doc, L"/result/iban/date");
-	is->Source = _nip24_parse_str(doc, L"/result/iban/source", NULL);
+	if (is && cached) {
+		cache_put(nip24->cache, &ck, is);
+	}
 
 err:
 	if (doc) {
@@ -1423,7 +2285,6 @@ err:
 	}
 
 	free(code);
-	free(ib);
 
 	return is;
 }
@@ -1437,32 +2298,27 @@ NIP24_API WLStatus* nip24_get_whitelist_status(NIP24Client* nip24, Number type,
 {
 	IXMLDOMDocument2* doc = NULL;
 	WLStatus* ws = NULL;
+	CacheKey ck;
+	CacheKey dk;
 
-	char iban_str[MAX_STRING];
 	char date_str[MAX_STRING];
 	char url[MAX_STRING];
+	char ib[MAX_NUMBER];
 
 	char* code = NULL;
-	char* ib = NULL;
+
+	BOOL cached;
 
 	if (!nip24 || type < NIP || type > KRS || !number || strlen(number) == 0 || !iban || strlen(iban) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
 		goto err;
 	}
 
-	snprintf(iban_str, sizeof(iban_str), "%s", iban);
-
-	if (!nip24_iban_is_valid(iban_str)) {
-		snprintf(iban_str, sizeof(iban_str), "PL%s", iban);
-
-		if (!nip24_iban_is_valid(iban_str)) {
-			_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
-			goto err;
-		}
+	if (!_nip24_check_iban(iban, ib, sizeof(ib))) {
+		_nip24_set_err(nip24, NIP24_ERR_CLI_IBAN, NULL);
+		goto err;
 	}
 
-	ib = nip24_iban_normalize(iban_str);
-
 	if (date <= 0) {
 		date = time(NULL);
 	}
@@ -1472,6 +2328,19 @@ NIP24_API WLStatus* nip24_get_whitelist_status(NIP24Client* nip24, Number type,
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_WHITELIST, type, number, ib, date, &ck);
+
+	if (cached && _nip24_cache_get(nip24, &ck, NULL, (void**)&ws)) {
+		goto err;
+	}
+
+	// status wyznaczony z zapamietanego wyniku wyszukiwania w rejestrze VAT z tego samego dnia
+	if (cached && _nip24_cache_key(nip24, NIP24_ENDPOINT_SEARCH, type, number, NULL, date, &dk)
+		&& (ws = derive_whitelist_status(nip24->cache, &dk, ib)) != NULL) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/check/whitelist/", nip24->url);
 
@@ -1496,28 +2365,19 @@ NIP24_API WLStatus* nip24_get_whitelist_status(NIP24Client* nip24, Number type,
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
 
-	if (!wlstatus_new(&ws)) {
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
+		}
+
 		goto err;
 	}
 
-	ws->UID = _nip24_parse_str(doc, L"/result/whitelist/uid", NULL);
-
-	ws->NIP = _nip24_parse_str(doc, L"/result/whitelist/nip", NULL);
-	ws->IBAN = _nip24_parse_str(doc, L"/result/whitelist/iban", NULL);
-
-	ws->Valid = _nip24_parse_bool(doc, L"/result/whitelist/valid", FALSE);
-	ws->Virtual = _nip24_parse_bool(doc, L"/result/whitelist/virtual", FALSE);
-
-	ws->Status = _nip24_parse_int(doc, L"/result/whitelist/vatStatus", 0);
-	ws->Result = _nip24_parse_str(doc, L"/result/whitelist/vatResult", NULL);
+	ws = decode_whitelist_status(doc);
 
-	ws->HashIndex = _nip24_parse_int(doc, L"/result/whitelist/hashIndex", -1);
-	ws->MaskIndex = _nip24_parse_int(doc, L"/result/whitelist/maskIndex", -1);
-	ws->Date = _nip24_parse_date(doc, L"/result/whitelist/date");
-	ws->Source = _nip24_parse_str(doc, L"/result/whitelist/source", NULL);
+	if (ws && cached) {
+		cache_put(nip24->cache, &ck, ws);
+	}
 
 err:
 	if (doc) {
@@ -1525,7 +2385,6 @@ err:
 	}
 
 	free(code);
-	free(ib);
 
 	return ws;
 }
@@ -1539,18 +2398,14 @@ NIP24_API SearchResult* nip24_search_vat_registry(NIP24Client* nip24, Number typ
 {
 	IXMLDOMDocument2* doc = NULL;
 	SearchResult* sr = NULL;
-	VATEntity* ve = NULL;
-
-	wchar_t xpath[MAX_STRING];
+	CacheKey ck;
 
 	char date_str[MAX_STRING];
 	char url[MAX_STRING];
 
 	char* code = NULL;
-	char* str = NULL;
 
-	int i;
-	int k;
+	BOOL cached;
 
 	if (!nip24 || type < NIP || type > IBAN || !number || strlen(number) == 0) {
 		_nip24_set_err(nip24, NIP24_ERR_CLI_INPUT, NULL);
@@ -1566,6 +2421,13 @@ NIP24_API SearchResult* nip24_search_vat_registry(NIP24Client* nip24, Number typ
 	// clear error
 	_nip24_clear_err(nip24);
 
+	// pamiec podreczna
+	cached = _nip24_cache_key(nip24, NIP24_ENDPOINT_SEARCH, type, number, NULL, date, &ck);
+
+	if (cached && _nip24_cache_get(nip24, &ck, NULL, (void**)&sr)) {
+		goto err;
+	}
+
 	// validate number and construct path
 	snprintf(url, sizeof(url), "%s/search/vat/", nip24->url);
 
@@ -1588,135 +2450,26 @@ NIP24_API SearchResult* nip24_search_vat_registry(NIP24Client* nip24, Number typ
 	if (code && strlen(code) > 0) {
 		// error
 		_nip24_set_err(nip24, atoi(code), _nip24_parse_str(doc, L"/result/error/description", NULL));
-		goto err;
-	}
-
-	if (!searchresult_new(&sr)) {
-		goto err;
-	}
-
-	sr->UID = _nip24_parse_str(doc, L"/result/search/uid", NULL);
-	sr->ResultsType = NIP24_RESULT_VAT_ENTITY;
-
-	for (i = 1; ; i++) {
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/nip", i);
-		str = _nip24_parse_str(doc, xpath, NULL);
-
-		if (!str || strlen(str) == 0) {
-			break;
-		}
-
-		if (!vatentity_new(&ve)) {
-			searchresult_free(&sr);
-			goto err;
-		}
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/name", i);
-		ve->Name = _nip24_parse_str(doc, xpath, NULL);
-
-		ve->NIP = str;
-		str = NULL;
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/regon", i);
-		ve->REGON = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/krs", i);
-		ve->KRS = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/residenceAddress", i);
-		ve->ResidenceAddress = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/workingAddress", i);
-		ve->WorkingAddress = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/vat/status", i);
-		ve->VATStatus = _nip24_parse_int(doc, xpath, 0);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/vat/result", i);
-		ve->VATResult = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/representatives", i);
-		_nip24_parse_vatperson(doc, xpath, &ve->Representatives, &ve->RepresentativesCount);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/authorizedClerks", i);
-		_nip24_parse_vatperson(doc, xpath, &ve->AuthorizedClerks, &ve->AuthorizedClerksCount);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/partners", i);
-		_nip24_parse_vatperson(doc, xpath, &ve->Partners, &ve->PartnersCount);
-
-		for (k = 1; ; k++) {
-			_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/ibans/iban[%d]", i, k);
-			str = _nip24_parse_str(doc, xpath, NULL);
-
-			if (!str || strlen(str) == 0) {
-				break;
-			}
-
-			// add
-			ve->IBANsCount++;
 
-			if ((ve->IBANs = (char**)realloc(ve->IBANs, sizeof(char*) * ve->IBANsCount)) == NULL) {
-				searchresult_free(&sr);
-				goto err;
-			}
-
-			ve->IBANs[ve->IBANsCount - 1] = str;
-			str = NULL;
+		if (cached) {
+			cache_put_error(nip24->cache, &ck, nip24_get_last_err_code(nip24), nip24_get_last_err(nip24));
 		}
 
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/hasVirtualAccounts", i);
-		str = _nip24_parse_str(doc, xpath, "false");
-		ve->HasVirtualAccounts = (strcmp(str, "true") == 0 ? TRUE : FALSE);
-
-		free(str);
-		str = NULL;
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationLegalDate", i);
-		ve->RegistrationLegalDate = _nip24_parse_date(doc, xpath);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationDenialDate", i);
-		ve->RegistrationDenialDate = _nip24_parse_date(doc, xpath);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/registrationDenialBasis", i);
-		ve->RegistrationDenialBasis = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/restorationDate", i);
-		ve->RestorationDate = _nip24_parse_date(doc, xpath);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/restorationBasis", i);
-		ve->RestorationBasis = _nip24_parse_str(doc, xpath, NULL);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/removalDate", i);
-		ve->RemovalDate = _nip24_parse_date(doc, xpath);
-
-		_snwprintf(xpath, MAX_STRING, L"/result/search/entities/entity[%d]/removalBasis", i);
-		ve->RemovalBasis = _nip24_parse_str(doc, xpath, NULL);
-
-		// add
-		sr->ResultsCount++;
+		goto err;
+	}
 
-		if ((sr->Results.VATEntity = (VATEntity**)realloc(sr->Results.VATEntity, sizeof(VATEntity*) * sr->ResultsCount)) == NULL) {
-			searchresult_free(&sr);
-			goto err;
-		}
+	sr = decode_search_result(doc);
 
-		sr->Results.VATEntity[sr->ResultsCount - 1] = ve;
-		ve = NULL;
+	if (sr && cached) {
+		cache_put(nip24->cache, &ck, sr);
 	}
 
-	sr->ID = _nip24_parse_str(doc, L"/result/search/id", NULL);
-	sr->Date = _nip24_parse_date(doc, L"/result/search/date");
-	sr->Source = _nip24_parse_str(doc, L"/result/search/source", NULL);
-
 err:
 	if (doc) {
 		doc->lpVtbl->Release(doc);
 	}
 
-	vatentity_free(&ve);
-
 	free(code);
-	free(str);
 
 	return sr;
 }
@@ -1761,58 +2514,7 @@ NIP24_API AccountStatus* nip24_get_account_status(NIP24Client* nip24)
 		goto err;
 	}
 
-	if (!accountstatus_new(&status)) {
-		goto err;
-	}
-
-	status->UID = _nip24_parse_str(doc, L"/result/account/uid", NULL);
-	status->Type = _nip24_parse_str(doc, L"/result/account/type", NULL);
-	status->ValidTo = _nip24_parse_datetime(doc, L"/result/account/validTo");
-	status->BillingPlanName = _nip24_parse_str(doc, L"/result/account/billingPlan/name", NULL);
-
-	status->SubscriptionPrice = _nip24_parse_double(doc, L"/result/account/billingPlan/subscriptionPrice", 0);
-	status->ItemPrice = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPrice", 0);
-	status->ItemPriceStatus = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceCheckStatus", 0);
-	status->ItemPriceInvoice = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceInvoiceData", 0);
-	status->ItemPriceAll = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceAllData", 0);
-	status->ItemPriceIBAN = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceAllIBAN", 0);
-	status->ItemPriceWhitelist = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceWLStatus", 0);
-	status->ItemPriceSearchVAT = _nip24_parse_double(doc, L"/result/account/billingPlan/itemPriceSearchVAT", 0);
-
-	status->Limit = _nip24_parse_int(doc, L"/result/account/billingPlan/limit", 0);
-	status->RequestDelay = _nip24_parse_int(doc, L"/result/account/billingPlan/requestDelay", 0);
-	status->DomainLimit = _nip24_parse_int(doc, L"/result/account/billingPlan/domainLimit", 0);
-
-	status->OverPlanAllowed = _nip24_parse_bool(doc, L"/result/account/billingPlan/overplanAllowed", FALSE);
-	status->TerytCodes = _nip24_parse_bool(doc, L"/result/account/billingPlan/terytCodes", FALSE);
-	status->ExcelAddIn = _nip24_parse_bool(doc, L"/result/account/billingPlan/excelAddin", FALSE);
-	status->JPKVAT = _nip24_parse_bool(doc, L"/result/account/billingPlan/jpkVat", FALSE);
-	status->CLI = _nip24_parse_bool(doc, L"/result/account/billingPlan/cli", FALSE);
-	status->Stats = _nip24_parse_bool(doc, L"/result/account/billingPlan/stats", FALSE);
-	status->NIPMonitor = _nip24_parse_bool(doc, L"/result/account/billingPlan/nipMonitor", FALSE);
-
-	status->SearchByNIP = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByNip", FALSE);
-	status->SearchByREGON = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByRegon", FALSE);
-	status->SearchByKRS = _nip24_parse_bool(doc, L"/result/account/billingPlan/searchByKrs", FALSE);
-
-	status->FuncIsActive = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcIsActive", FALSE);
-	status->FuncGetInvoiceData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetInvoiceData", FALSE);
-	status->FuncGetAllData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetAllData", FALSE);
-	status->FuncGetVIESData = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetVIESData", FALSE);
-	status->FuncGetVATStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetVATStatus", FALSE);
-	status->FuncGetIBANStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetIBANStatus", FALSE);
-	status->FuncGetWhitelistStatus = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcGetWLStatus", FALSE);
-	status->FuncSearchVAT = _nip24_parse_bool(doc, L"/result/account/billingPlan/funcSearchVAT", FALSE);
-
-	status->InvoiceDataCount = _nip24_parse_int(doc, L"/result/account/requests/invoiceData", 0);
-	status->AllDataCount = _nip24_parse_int(doc, L"/result/account/requests/allData", 0);
-	status->FirmStatusCount = _nip24_parse_int(doc, L"/result/account/requests/firmStatus", 0);
-	status->VATStatusCount = _nip24_parse_int(doc, L"/result/account/requests/vatStatus", 0);
-	status->VIESStatusCount = _nip24_parse_int(doc, L"/result/account/requests/viesStatus", 0);
-	status->IBANStatusCount = _nip24_parse_int(doc, L"/result/account/requests/ibanStatus", 0);
-	status->WhitelistStatusCount = _nip24_parse_int(doc, L"/result/account/requests/wlStatus", 0);
-	status->SearchVATCount = _nip24_parse_int(doc, L"/result/account/requests/searchVAT", 0);
-	status->TotalCount = _nip24_parse_int(doc, L"/result/account/requests/total", 0);
+	status = decode_account_status(doc);
 
 err:
 	if (doc) {
@@ -0,0 +1,199 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+/**
+ * Kopia ciagu znakow (NULL pozostaje NULL)
+ * @param str ciag znakow lub NULL
+ * @return kopia ciagu lub NULL
+ */
+static char* _nip24_derive_str(const char* str)
+{
+	return (str ? strdup(str) : NULL);
+}
+
+/**
+ * Odczyt z pamieci podrecznej wyniku wyszukiwania w rejestrze VAT, ktory jednoznacznie
+ * opisuje jeden podmiot
+ * @param cache obiekt pamieci podrecznej
+ * @param key klucz wyniku wyszukiwania
+ * @return wynik wyszukiwania (zwalniany przez wywolujacego) lub NULL
+ */
+static SearchResult* _nip24_derive_search(NIP24Cache* cache, const CacheKey* key)
+{
+	SearchResult* sr;
+
+	char* err;
+	int code;
+
+	if ((sr = (SearchResult*)cache_peek(cache, key, &code, &err, NULL)) == NULL) {
+		free(err);
+		return NULL;
+	}
+
+	if (sr->ResultsType != NIP24_RESULT_VAT_ENTITY || sr->ResultsCount != 1) {
+		searchresult_free(&sr);
+		return NULL;
+	}
+
+	return sr;
+}
+
+InvoiceData* derive_invoice_data(NIP24Cache* cache, const CacheKey* key)
+{
+	AllData* ad;
+	InvoiceData* id = NULL;
+
+	char* err;
+	int code;
+
+	if ((ad = (AllData*)cache_peek(cache, key, &code, &err, NULL)) == NULL) {
+		free(err);
+		goto err;
+	}
+
+	if (!invoicedata_new(&id)) {
+		goto err;
+	}
+
+	id->UID = _nip24_derive_str(ad->UID);
+
+	id->NIP = _nip24_derive_str(ad->NIP);
+	id->Name = _nip24_derive_str(ad->Name);
+	id->FirstName = _nip24_derive_str(ad->FirstName);
+	id->LastName = _nip24_derive_str(ad->LastName);
+
+	id->Street = _nip24_derive_str(ad->Street);
+	id->StreetNumber = _nip24_derive_str(ad->StreetNumber);
+	id->HouseNumber = _nip24_derive_str(ad->HouseNumber);
+	id->City = _nip24_derive_str(ad->City);
+	id->PostCode = _nip24_derive_str(ad->PostCode);
+	id->PostCity = _nip24_derive_str(ad->PostCity);
+
+	id->Phone = _nip24_derive_str(ad->Phone);
+	id->Email = _nip24_derive_str(ad->Email);
+	id->WWW = _nip24_derive_str(ad->WWW);
+
+	id->Derived = TRUE;
+
+err:
+	alldata_free(&ad);
+
+	return id;
+}
+
+VATStatus* derive_vat_status(NIP24Cache* cache, const CacheKey* key)
+{
+	SearchResult* sr;
+	VATEntity* ve;
+	VATStatus* vat = NULL;
+
+	if ((sr = _nip24_derive_search(cache, key)) == NULL) {
+		goto err;
+	}
+
+	if (!vatstatus_new(&vat)) {
+		goto err;
+	}
+
+	ve = sr->Results.VATEntity[0];
+
+	vat->UID = _nip24_derive_str(sr->UID);
+
+	vat->NIP = _nip24_derive_str(ve->NIP);
+	vat->REGON = _nip24_derive_str(ve->REGON);
+	vat->Name = _nip24_derive_str(ve->Name);
+
+	vat->Status = ve->VATStatus;
+	vat->Result = _nip24_derive_str(ve->VATResult);
+
+	vat->ID = _nip24_derive_str(sr->ID);
+	vat->Date = sr->Date;
+	vat->Source = _nip24_derive_str(sr->Source);
+
+	vat->Derived = TRUE;
+
+err:
+	searchresult_free(&sr);
+
+	return vat;
+}
+
+WLStatus* derive_whitelist_status(NIP24Cache* cache, const CacheKey* key, const char* iban)
+{
+	SearchResult* sr;
+	VATEntity* ve;
+	WLStatus* ws = NULL;
+	NIP24Key ik;
+	NIP24Key k;
+
+	BOOL valid = FALSE;
+
+	int i;
+
+	if (!cache_iban_key(iban, &ik)) {
+		return NULL;
+	}
+
+	if ((sr = _nip24_derive_search(cache, key)) == NULL) {
+		goto err;
+	}
+
+	ve = sr->Results.VATEntity[0];
+
+	for (i = 0; i < ve->IBANsCount && !valid; i++) {
+		valid = (cache_iban_key(ve->IBANs[i], &k) && memcmp(&k, &ik, sizeof(NIP24Key)) == 0);
+	}
+
+	// rachunku spoza wykazu nie mozna ocenic, jezeli firma ma rachunki wirtualne
+	if (!valid && ve->HasVirtualAccounts) {
+		goto err;
+	}
+
+	if (!wlstatus_new(&ws)) {
+		goto err;
+	}
+
+	ws->UID = _nip24_derive_str(sr->UID);
+
+	ws->NIP = _nip24_derive_str(ve->NIP);
+	ws->IBAN = strdup(iban);
+
+	ws->Valid = valid;
+	ws->Virtual = FALSE;
+
+	ws->Status = ve->VATStatus;
+	ws->Result = _nip24_derive_str(ve->VATResult);
+
+	ws->HashIndex = -1;
+	ws->MaskIndex = -1;
+	ws->Date = sr->Date;
+	ws->Source = _nip24_derive_str(sr->Source);
+
+	ws->Derived = TRUE;
+
+err:
+	searchresult_free(&sr);
+
+	return ws;
+}
@@ -33,12 +33,13 @@ static const char* _nip24_codes[] = {
     /* NIP24_ERR_CLI_IBAN */        "Numer IBAN jest nieprawidowy",
     /* NIP24_ERR_CLI_EXCEPTION */   "Funkcja wygenerowaa wyjtek",
     /* NIP24_ERR_CLI_DATEFORMAT */  "Podana data ma nieprawidowy format",
-    /* NIP24_ERR_CLI_INPUT */       "Nieprawidowy parametr wejciowy funkcji"
+    /* NIP24_ERR_CLI_INPUT */       "Nieprawidowy parametr wejciowy funkcji",
+    /* NIP24_ERR_CLI_CANCELLED */   "Operacja zostaa przerwana"
 };
 
 NIP24_API const char* nip24_errstr(int code)
 {
-    if (code < NIP24_ERR_CLI_CONNECT || code > NIP24_ERR_CLI_DATEFORMAT) {
+    if (code < NIP24_ERR_CLI_CONNECT || code > NIP24_ERR_CLI_CANCELLED) {
         return NULL;
     }
 
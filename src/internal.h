@@ -38,6 +38,8 @@
 #include <objbase.h>  
 #include <msxml2.h>
 
+#include "nip24.h"
+
  /////////////////////////////////////////////////////////////////
 
 #define strdup			_strdup
@@ -47,6 +49,11 @@
 #define MAX_STRING		1024
 #define MAX_NUMBER		40
 
+#define COUNTRY2IDX(a, b)	(((a) - 'A') * 26 + ((b) - 'A'))
+
+#define RUNS_MAX		4
+#define RUN_VAR			0xff
+
  /////////////////////////////////////////////////////////////////
 
 typedef struct KEYDATA {
@@ -55,12 +62,96 @@ typedef struct KEYDATA {
 	unsigned char key[128];
 } KEYDATA;
 
+/**
+ * Ciag znakow okreslonej klasy: 'n' - cyfry, 'a' - litery, 'c' - litery lub cyfry,
+ * 'x' - litery, cyfry, '+' lub '*' (RUN_VAR - ciag o zmiennej dlugosci)
+ */
+typedef struct FormatRun {
+	char type;
+	unsigned char count;
+} FormatRun;
+
+/**
+ * Klucz wpisu pamieci podrecznej (dzien w postaci RRRRMMDD, 0 - bez daty)
+ */
+typedef struct CacheKey {
+	NIP24Key number;
+	NIP24Key iban;
+	int endpoint;
+	int date;
+} CacheKey;
+
+/**
+ * Trwaly magazyn odpowiedzi na dysku (store.c)
+ */
+typedef struct CacheStore CacheStore;
+
+/**
+ * Pamiec podreczna wspoldzielona przez procesy (shared.c)
+ */
+typedef struct CacheShared CacheShared;
+
+/**
+ * Trwajace zapytanie HTTP, na ktorego odpowiedz czekaja inni klienci
+ */
+typedef struct CacheFlight CacheFlight;
+
 /////////////////////////////////////////////////////////////////
 
 BOOL utf8_to_bstr(const char* str, BSTR* bstr);
 BOOL bstr_to_utf8(const BSTR bstr, char** str);
 int bstr_replace(BSTR* bstr, BSTR rep, BSTR with);
 
+const FormatRun* iban_format(const char* num, int* length);
+
+BOOL load_xml(const char* xml, IXMLDOMDocument2** doc);
+
+InvoiceData* decode_invoice_data(IXMLDOMDocument2* doc);
+AllData* decode_all_data(IXMLDOMDocument2* doc);
+VIESData* decode_vies_data(IXMLDOMDocument2* doc);
+VATStatus* decode_vat_status(IXMLDOMDocument2* doc);
+IBANStatus* decode_iban_status(IXMLDOMDocument2* doc);
+WLStatus* decode_whitelist_status(IXMLDOMDocument2* doc);
+SearchResult* decode_search_result(IXMLDOMDocument2* doc);
+AccountStatus* decode_account_status(IXMLDOMDocument2* doc);
+
+BOOL client_clone(NIP24Client* nip24, NIP24Client** copy);
+void client_release_err(NIP24Client* nip24);
+
+BOOL record_encode(Endpoint endpoint, const void* obj, uint8_t** data, size_t* len);
+void* record_decode(Endpoint endpoint, const uint8_t* data, size_t len);
+BOOL record_encode_error(int code, const char* err, uint8_t** data, size_t* len);
+BOOL record_decode_error(const uint8_t* data, size_t len, int* code, char** err);
+
+BOOL cache_iban_key(const char* iban, NIP24Key* key);
+BOOL cache_key(CacheKey* key, Endpoint endpoint, Number type, const char* number, const char* iban, int date);
+void* cache_get(NIP24Cache* cache, const CacheKey* key, int* code, char** err, BOOL* stale);
+void* cache_peek(NIP24Cache* cache, const CacheKey* key, int* code, char** err, BOOL* stale);
+BOOL cache_put(NIP24Cache* cache, const CacheKey* key, const void* obj);
+BOOL cache_put_error(NIP24Cache* cache, const CacheKey* key, int code, const char* err);
+BOOL cache_firm_error(int code);
+
+CacheFlight* cache_flight_join(NIP24Cache* cache, const char* url, BOOL* leader);
+void cache_flight_done(NIP24Cache* cache, CacheFlight* flight, const BSTR resp);
+BOOL cache_flight_wait(NIP24Cache* cache, CacheFlight* flight, BSTR* resp);
+
+BOOL cache_refresh_begin(NIP24Cache* cache, const CacheKey* key);
+void cache_refresh_end(NIP24Cache* cache, const CacheKey* key);
+
+InvoiceData* derive_invoice_data(NIP24Cache* cache, const CacheKey* key);
+VATStatus* derive_vat_status(NIP24Cache* cache, const CacheKey* key);
+WLStatus* derive_whitelist_status(NIP24Cache* cache, const CacheKey* key, const char* iban);
+
+BOOL store_open(CacheStore** store, const char* path);
+void store_close(CacheStore** store);
+BOOL store_get(CacheStore* store, const CacheKey* key, uint64_t hash, uint8_t** data, size_t* len, time_t* expires);
+BOOL store_put(CacheStore* store, const CacheKey* key, uint64_t hash, const uint8_t* data, size_t len, time_t expires);
+
+BOOL shared_open(CacheShared** shm, const char* name, size_t size);
+void shared_close(CacheShared** shm);
+BOOL shared_get(CacheShared* shm, const CacheKey* key, uint64_t hash, uint8_t** data, size_t* len, time_t* expires);
+BOOL shared_put(CacheShared* shm, const CacheKey* key, uint64_t hash, const uint8_t* data, size_t len, time_t expires);
+
 /////////////////////////////////////////////////////////////////
 
 #endif
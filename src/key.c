@@ -0,0 +1,292 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define KEY_TYPE_SHIFT		60
+#define KEY_HASHED			((uint64_t)1 << 59)
+#define KEY_COUNTRY_SHIFT	48
+#define KEY_LENGTH_SHIFT	40
+#define KEY_PAYLOAD_MASK	(((uint64_t)1 << 40) - 1)
+
+#define EUVAT_CHARS			"0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ+*"
+
+static BOOL _nip24_key_mul_add(NIP24Key* key, unsigned int m, unsigned int a)
+{
+	uint64_t l0 = (key->lo & 0xffffffff) * m + a;
+	uint64_t l1 = (key->lo >> 32) * m + (l0 >> 32);
+
+	key->lo = (l1 << 32) | (l0 & 0xffffffff);
+	key->hi = key->hi * m + (l1 >> 32);
+
+	// wartosc musi sie zmiescic w 104 bitach
+	return (key->hi <= KEY_PAYLOAD_MASK);
+}
+
+static unsigned int _nip24_key_div(NIP24Key* key, unsigned int m)
+{
+	uint64_t l1;
+	uint64_t l0;
+	uint64_t r;
+
+	r = key->hi % m;
+	key->hi /= m;
+
+	l1 = (r << 32) | (key->lo >> 32);
+	r = l1 % m;
+	l1 /= m;
+
+	l0 = (r << 32) | (key->lo & 0xffffffff);
+	r = l0 % m;
+	l0 /= m;
+
+	key->lo = (l1 << 32) | l0;
+
+	return (unsigned int)r;
+}
+
+static unsigned int _nip24_key_radix(char type)
+{
+	return (type == 'n' ? 10 : type == 'a' ? 26 : 36);
+}
+
+static void _nip24_key_hash_str(const char* num, NIP24Key* key)
+{
+	uint64_t h1 = 0xcbf29ce484222325ULL;
+	uint64_t h2 = 0x84222325cbf29ce4ULL;
+
+	// dwa skroty FNV-1a o roznych wartosciach poczatkowych
+	for (; *num; num++) {
+		h1 = (h1 ^ (unsigned char)*num) * 0x100000001b3ULL;
+		h2 = (h2 ^ (unsigned char)*num) * 0x100000001b3ULL;
+	}
+
+	key->hi = (h2 & KEY_PAYLOAD_MASK) | KEY_HASHED;
+	key->lo = h1;
+}
+
+static BOOL _nip24_key_pack_iban(const char* num, NIP24Key* key)
+{
+	const FormatRun* run;
+
+	unsigned int radix;
+	int length;
+	int p;
+	int i;
+	int j;
+
+	if (!(run = iban_format(num, &length))) {
+		return FALSE;
+	}
+
+	// liczba o mieszanej podstawie wg formatu kraju: cyfry 10, litery 26, pozostale 36
+	for (i = 0, p = 2; i < RUNS_MAX && run[i].count > 0; i++) {
+		radix = _nip24_key_radix(run[i].type);
+
+		for (j = 0; j < run[i].count; j++, p++) {
+			if (!_nip24_key_mul_add(key, radix, (isdigit(num[p]) ? num[p] - '0'
+				: num[p] - 'A' + (radix == 26 ? 0 : 10)))) {
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+static BOOL _nip24_key_unpack_iban(NIP24Key* key, char* out, int len)
+{
+	const FormatRun* run;
+
+	char types[MAX_NUMBER];
+	unsigned int v;
+	int length;
+	int p;
+	int i;
+	int j;
+
+	if (!(run = iban_format(out, &length)) || length != len) {
+		return FALSE;
+	}
+
+	for (i = 0, p = 2; i < RUNS_MAX && run[i].count > 0; i++) {
+		for (j = 0; j < run[i].count; j++, p++) {
+			types[p] = run[i].type;
+		}
+	}
+
+	for (p = len - 1; p >= 2; p--) {
+		v = _nip24_key_div(key, _nip24_key_radix(types[p]));
+
+		if (types[p] == 'n') {
+			out[p] = '0' + v;
+		}
+		else if (types[p] == 'a') {
+			out[p] = 'A' + v;
+		}
+		else {
+			out[p] = (v < 10 ? '0' + v : 'A' + v - 10);
+		}
+	}
+
+	return TRUE;
+}
+
+/////////////////////////////////////////////////////////////////
+
+NIP24_API BOOL nip24_key_from_number(Number type, const char* number, NIP24Key* key)
+{
+	NIP24Key k = { 0, 0 };
+
+	char num[MAX_NUMBER];
+	int country = 0;
+	int len;
+	int i;
+
+	if (!key || !nip24_number_check(type, number, num, sizeof(num))) {
+		return FALSE;
+	}
+
+	len = (int)strlen(num);
+
+	if (type == NIP || type == REGON || type == KRS) {
+		for (i = 0; i < len; i++) {
+			k.lo = k.lo * 10 + (num[i] - '0');
+		}
+	}
+	else if (type == EUVAT) {
+		country = COUNTRY2IDX(num[0], num[1]);
+
+		// do 12 znakow o podstawie 38 miesci sie w 64 bitach
+		for (i = 2; i < len; i++) {
+			k.lo = k.lo * 38 + (strchr(EUVAT_CHARS, num[i]) - EUVAT_CHARS);
+		}
+	}
+	else if (type == IBAN) {
+		country = COUNTRY2IDX(num[0], num[1]);
+
+		// numery, ktore nie mieszcza sie w 104 bitach, zapisywane sa jako skrot
+		if (!_nip24_key_pack_iban(num, &k)) {
+			_nip24_key_hash_str(num, &k);
+		}
+	}
+	else {
+		return FALSE;
+	}
+
+	k.hi |= ((uint64_t)type << KEY_TYPE_SHIFT) | ((uint64_t)country << KEY_COUNTRY_SHIFT)
+		| ((uint64_t)len << KEY_LENGTH_SHIFT);
+
+	*key = k;
+
+	return TRUE;
+}
+
+NIP24_API BOOL nip24_key_to_string(const NIP24Key* key, char* out, size_t size)
+{
+	NIP24Key k;
+
+	Number type;
+	int country;
+	int len;
+	int i;
+
+	if (!key || !out || size < 33 || (key->hi & KEY_HASHED)) {
+		return FALSE;
+	}
+
+	type = nip24_key_type(key);
+	country = (int)((key->hi >> KEY_COUNTRY_SHIFT) & 0x3ff);
+	len = (int)((key->hi >> KEY_LENGTH_SHIFT) & 0xff);
+
+	if (len < 2 || len > 32) {
+		return FALSE;
+	}
+
+	k.hi = key->hi & KEY_PAYLOAD_MASK;
+	k.lo = key->lo;
+
+	if (type == NIP || type == REGON || type == KRS) {
+		for (i = len - 1; i >= 0; i--) {
+			out[i] = '0' + (char)(k.lo % 10);
+			k.lo /= 10;
+		}
+	}
+	else if (type == EUVAT || type == IBAN) {
+		out[0] = 'A' + country / 26;
+		out[1] = 'A' + country % 26;
+
+		if (type == EUVAT) {
+			for (i = len - 1; i >= 2; i--) {
+				out[i] = EUVAT_CHARS[k.lo % 38];
+				k.lo /= 38;
+			}
+		}
+		else if (!_nip24_key_unpack_iban(&k, out, len)) {
+			return FALSE;
+		}
+	}
+	else {
+		return FALSE;
+	}
+
+	out[len] = '\0';
+
+	return TRUE;
+}
+
+NIP24_API Number nip24_key_type(const NIP24Key* key)
+{
+	return (Number)(key->hi >> KEY_TYPE_SHIFT);
+}
+
+NIP24_API uint64_t nip24_key_hash(const NIP24Key* key)
+{
+	uint64_t h = key->lo ^ (key->hi * 0x9e3779b97f4a7c15ULL);
+
+	// mieszanie bitow (finalizer MurmurHash3)
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+NIP24_API int nip24_key_compare(const NIP24Key* k1, const NIP24Key* k2)
+{
+	if (k1->hi != k2->hi) {
+		return (k1->hi < k2->hi ? -1 : 1);
+	}
+
+	if (k1->lo != k2->lo) {
+		return (k1->lo < k2->lo ? -1 : 1);
+	}
+
+	return 0;
+}
+
+NIP24_API BOOL nip24_key_equals(const NIP24Key* k1, const NIP24Key* k2)
+{
+	return (k1->hi == k2->hi && k1->lo == k2->lo);
+}
@@ -0,0 +1,395 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define PREWARM_THREADS		MAXIMUM_WAIT_OBJECTS
+
+/**
+ * Wspolny stan rozgrzewania pamieci podrecznej. Zadanie j dotyczy numeru j / ecount i metody
+ * endpoint[j % ecount].
+ */
+typedef struct Prewarm {
+	NIP24Client* nip24;
+
+	Number type;
+	char** numbers;
+	int count;
+
+	int endpoint[NIP24_ENDPOINT_COUNT];
+	int ecount;
+
+	volatile LONG next;
+	int total;
+
+	CRITICAL_SECTION lock;
+
+	DWORD slot;
+	DWORD interval;
+
+	int done;
+	int ok;
+	volatile BOOL cancel;
+
+	NIP24Progress progress;
+	void* ctx;
+} Prewarm;
+
+/////////////////////////////////////////////////////////////////
+
+static int _nip24_prewarm_compare(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void _nip24_prewarm_free(Endpoint endpoint, void* obj)
+{
+	if (!obj) {
+		return;
+	}
+
+	if (endpoint == NIP24_ENDPOINT_INVOICE) {
+		invoicedata_free((InvoiceData**)&obj);
+	}
+	else if (endpoint == NIP24_ENDPOINT_ALL) {
+		alldata_free((AllData**)&obj);
+	}
+	else if (endpoint == NIP24_ENDPOINT_VIES) {
+		viesdata_free((VIESData**)&obj);
+	}
+	else if (endpoint == NIP24_ENDPOINT_VAT) {
+		vatstatus_free((VATStatus**)&obj);
+	}
+	else if (endpoint == NIP24_ENDPOINT_SEARCH) {
+		searchresult_free((SearchResult**)&obj);
+	}
+}
+
+/**
+ * Oczekiwanie na kolejne zapytanie w ramach limitu liczby zapytan na sekunde
+ */
+static void _nip24_prewarm_wait(Prewarm* pw)
+{
+	DWORD now;
+	DWORD wait = 0;
+
+	if (pw->interval == 0) {
+		return;
+	}
+
+	EnterCriticalSection(&pw->lock);
+
+	now = GetTickCount();
+
+	if ((LONG)(pw->slot - now) > 0) {
+		wait = pw->slot - now;
+	}
+	else {
+		pw->slot = now;
+	}
+
+	pw->slot += pw->interval;
+
+	LeaveCriticalSection(&pw->lock);
+
+	if (wait > 0) {
+		Sleep(wait);
+	}
+}
+
+/**
+ * Rozgrzanie jednej odpowiedzi: odczyt z pamieci podrecznej (rowniez z segmentu wspoldzielonego
+ * i magazynu na dysku) lub zapytanie do serwisu
+ * @return TRUE jezeli odpowiedz jest w pamieci podrecznej
+ */
+static BOOL _nip24_prewarm_one(Prewarm* pw, NIP24Client* nip24, const char* number, Endpoint endpoint)
+{
+	CacheKey key;
+	struct tm* tm;
+	time_t now = time(NULL);
+
+	void* obj = NULL;
+	char* err;
+	int code;
+	int day = 0;
+
+	BOOL stale;
+	BOOL ret;
+
+	if (endpoint == NIP24_ENDPOINT_SEARCH) {
+		tm = localtime(&now);
+		day = (tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 + tm->tm_mday;
+	}
+
+	// odczyt bez statystyk i szkicu czestotliwosci - liczone jest tylko zapytanie ponizej;
+	// nieaktualne dane do faktury odswieza zwykla sciezka zapytania
+	if (cache_key(&key, endpoint, pw->type, number, NULL, day)) {
+		if ((obj = cache_peek(nip24->cache, &key, &code, &err, &stale)) != NULL || code != 0) {
+			_nip24_prewarm_free(endpoint, obj);
+			free(err);
+
+			if (!stale) {
+				return TRUE;
+			}
+
+			obj = NULL;
+		}
+	}
+
+	_nip24_prewarm_wait(pw);
+
+	if (endpoint == NIP24_ENDPOINT_INVOICE) {
+		obj = nip24_get_invoice_data(nip24, pw->type, number, FALSE);
+	}
+	else if (endpoint == NIP24_ENDPOINT_ALL) {
+		obj = nip24_get_all_data(nip24, pw->type, number, FALSE);
+	}
+	else if (endpoint == NIP24_ENDPOINT_VIES) {
+		obj = nip24_get_vies_data(nip24, number);
+	}
+	else if (endpoint == NIP24_ENDPOINT_VAT) {
+		obj = nip24_get_vat_status(nip24, pw->type, number, FALSE);
+	}
+	else if (endpoint == NIP24_ENDPOINT_SEARCH) {
+		obj = nip24_search_vat_registry(nip24, pw->type, number, now);
+	}
+
+	// odpowiedzi negatywne rowniez trafiaja do pamieci podrecznej
+	code = nip24_get_last_err_code(nip24);
+
+	ret = (obj || code == NIP24_ERR_NIP_NOT_ACTIVE || code == NIP24_ERR_NIP_UNKNOWN || code == NIP24_ERR_NIP_BAD);
+
+	_nip24_prewarm_free(endpoint, obj);
+
+	return ret;
+}
+
+static DWORD WINAPI _nip24_prewarm_proc(LPVOID param)
+{
+	Prewarm* pw = (Prewarm*)param;
+
+	LONG j;
+	BOOL ok;
+
+	CoInitialize(NULL);
+
+	while (!pw->cancel && (j = InterlockedIncrement(&pw->next) - 1) < pw->total) {
+		ok = _nip24_prewarm_one(pw, pw->nip24, pw->numbers[j / pw->ecount], (Endpoint)pw->endpoint[j % pw->ecount]);
+
+		EnterCriticalSection(&pw->lock);
+
+		pw->done++;
+
+		if (ok) {
+			pw->ok++;
+		}
+
+		if (pw->progress && !pw->cancel && !pw->progress(pw->ctx, pw->done, pw->total)) {
+			pw->cancel = TRUE;
+		}
+
+		LeaveCriticalSection(&pw->lock);
+	}
+
+	client_release_err(pw->nip24);
+
+	CoUninitialize();
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////
+
+NIP24_API int nip24_cache_prewarm(NIP24Client* nip24, Number type, const char* const* numbers, int count,
+	unsigned int endpoints, int concurrency, int rate, NIP24Progress progress, void* ctx)
+{
+	HANDLE threads[PREWARM_THREADS];
+	Prewarm pw;
+
+	char n[MAX_STRING];
+
+	int threads_count = 0;
+	int ret = -1;
+	int i;
+	int k;
+
+	memset(&pw, 0, sizeof(pw));
+
+	if (!nip24 || !nip24->cache || type < NIP || type > EUVAT || (!numbers && count > 0) || count < 0
+		|| endpoints == 0 || concurrency < 1 || rate < 0) {
+		return -1;
+	}
+
+	if (endpoints >> NIP24_ENDPOINT_COUNT) {
+		return -1;
+	}
+
+	for (i = 0; i < NIP24_ENDPOINT_COUNT; i++) {
+		if (!(endpoints & NIP24_ENDPOINT_FLAG(i))) {
+			continue;
+		}
+
+		// metody wymagajace numeru IBAN nie sa rozgrzewane, dane VIES tylko dla numerow EUVAT,
+		// status aktywnosci nie (pamiec podreczna przechowuje tylko odpowiedzi negatywne)
+		if (i == NIP24_ENDPOINT_IBAN || i == NIP24_ENDPOINT_WHITELIST || i == NIP24_ENDPOINT_ACTIVE
+			|| (i == NIP24_ENDPOINT_VIES && type != EUVAT)) {
+			return -1;
+		}
+
+		pw.endpoint[pw.ecount++] = i;
+	}
+
+	InitializeCriticalSection(&pw.lock);
+
+	// znormalizowane numery bez powtorzen
+	if ((pw.numbers = (char**)calloc(count + 1, sizeof(char*))) == NULL) {
+		goto err;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!numbers[i] || !nip24_number_check(type, numbers[i], n, sizeof(n))) {
+			continue;
+		}
+
+		if ((pw.numbers[pw.count] = strdup(n)) == NULL) {
+			goto err;
+		}
+
+		pw.count++;
+	}
+
+	qsort(pw.numbers, pw.count, sizeof(char*), _nip24_prewarm_compare);
+
+	for (i = 1, k = (pw.count > 0 ? 1 : 0); i < pw.count; i++) {
+		if (strcmp(pw.numbers[i], pw.numbers[k - 1]) == 0) {
+			free(pw.numbers[i]);
+		}
+		else {
+			pw.numbers[k++] = pw.numbers[i];
+		}
+	}
+
+	pw.count = k;
+
+	pw.nip24 = nip24;
+	pw.type = type;
+	pw.total = pw.count * pw.ecount;
+	pw.interval = (rate > 1000 ? 1 : (rate > 0 ? 1000 / rate : 0));
+	pw.slot = GetTickCount();
+	pw.progress = progress;
+	pw.ctx = ctx;
+
+	// watki robocze
+	for (i = 0; i < concurrency && i < PREWARM_THREADS && i < pw.total; i++) {
+		if ((threads[threads_count] = CreateThread(NULL, 0, _nip24_prewarm_proc, &pw, 0, NULL)) == NULL) {
+			break;
+		}
+
+		threads_count++;
+	}
+
+	if (threads_count == 0 && pw.total > 0) {
+		goto err;
+	}
+
+	if (threads_count > 0) {
+		WaitForMultipleObjects(threads_count, threads, TRUE, INFINITE);
+	}
+
+	for (i = 0; i < threads_count; i++) {
+		CloseHandle(threads[i]);
+	}
+
+	// ok
+	ret = pw.ok;
+
+err:
+	for (i = 0; i < pw.count; i++) {
+		free(pw.numbers[i]);
+	}
+
+	free(pw.numbers);
+
+	DeleteCriticalSection(&pw.lock);
+
+	return ret;
+}
+
+NIP24_API int nip24_cache_prewarm_file(NIP24Client* nip24, Number type, const char* path, unsigned int endpoints,
+	int concurrency, int rate, NIP24Progress progress, void* ctx)
+{
+	FILE* f = NULL;
+
+	char** numbers = NULL;
+	char** p;
+	char line[MAX_STRING];
+	char* s;
+	char* e;
+
+	int count = 0;
+	int ret = -1;
+	int i;
+
+	if (!path || (f = fopen(path, "r")) == NULL) {
+		goto err;
+	}
+
+	// jeden numer w wierszu, puste wiersze sa pomijane
+	while (fgets(line, sizeof(line), f)) {
+		for (s = line; *s == ' ' || *s == '\t'; s++);
+		for (e = s + strlen(s); e > s && (e[-1] == '\r' || e[-1] == '\n' || e[-1] == ' ' || e[-1] == '\t'); e--);
+
+		*e = '\0';
+
+		if (strlen(s) == 0) {
+			continue;
+		}
+
+		if ((p = (char**)realloc(numbers, (count + 1) * sizeof(char*))) == NULL) {
+			goto err;
+		}
+
+		numbers = p;
+
+		if ((numbers[count] = strdup(s)) == NULL) {
+			goto err;
+		}
+
+		count++;
+	}
+
+	ret = nip24_cache_prewarm(nip24, type, (const char* const*)numbers, count, endpoints, concurrency, rate,
+		progress, ctx);
+
+err:
+	if (f) {
+		fclose(f);
+	}
+
+	for (i = 0; i < count; i++) {
+		free(numbers[i]);
+	}
+
+	free(numbers);
+
+	return ret;
+}
@@ -0,0 +1,678 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+#include <stddef.h>
+
+
+#define RECORD_VERSION		1
+#define RECORD_ERROR		0
+
+/**
+ * Pole struktury wynikowej: 's' - ciag znakow, 'i' - int, 'b' - BOOL, 't' - time_t,
+ * 'a' - tablica ciagow znakow, 'l' - lista obiektow (count - offset licznika elementow)
+ */
+typedef struct RecordField {
+	char type;
+	size_t offset;
+	size_t count;
+	const struct RecordSchema* item;
+} RecordField;
+
+typedef struct RecordSchema {
+	size_t size;
+	const RecordField* field;
+	int count;
+} RecordSchema;
+
+typedef struct RecordBuffer {
+	uint8_t* data;
+	size_t len;
+	size_t size;
+} RecordBuffer;
+
+typedef struct RecordReader {
+	const uint8_t* p;
+	const uint8_t* end;
+} RecordReader;
+
+#define F_STR(t, f)			{ 's', offsetof(t, f), 0, NULL }
+#define F_INT(t, f)			{ 'i', offsetof(t, f), 0, NULL }
+#define F_BOOL(t, f)		{ 'b', offsetof(t, f), 0, NULL }
+#define F_TIME(t, f)		{ 't', offsetof(t, f), 0, NULL }
+#define F_STRS(t, f, n)		{ 'a', offsetof(t, f), offsetof(t, n), NULL }
+#define F_LIST(t, f, n, s)	{ 'l', offsetof(t, f), offsetof(t, n), &s }
+
+#define SCHEMA(name, t)		static const RecordSchema name = { sizeof(t), name##_fields, sizeof(name##_fields) / sizeof(RecordField) }
+
+#define FIELD(obj, f, t)	((t*)((char*)(obj) + (f)->offset))
+#define COUNT(obj, f)		((int*)((char*)(obj) + (f)->count))
+
+/////////////////////////////////////////////////////////////////
+
+static const RecordField _nip24_partner_fields[] = {
+	F_STR(BusinessPartner, REGON),
+	F_STR(BusinessPartner, FirmName),
+	F_STR(BusinessPartner, FirstName),
+	F_STR(BusinessPartner, SecondName),
+	F_STR(BusinessPartner, LastName)
+};
+
+SCHEMA(_nip24_partner, BusinessPartner);
+
+static const RecordField _nip24_pkd_fields[] = {
+	F_STR(PKD, Code),
+	F_STR(PKD, Description),
+	F_BOOL(PKD, Primary),
+	F_STR(PKD, Version)
+};
+
+SCHEMA(_nip24_pkd, PKD);
+
+static const RecordField _nip24_vatperson_fields[] = {
+	F_STR(VATPerson, CompanyName),
+	F_STR(VATPerson, FirstName),
+	F_STR(VATPerson, LastName),
+	F_STR(VATPerson, NIP)
+};
+
+SCHEMA(_nip24_vatperson, VATPerson);
+
+static const RecordField _nip24_vatentity_fields[] = {
+	F_STR(VATEntity, Name),
+	F_STR(VATEntity, NIP),
+	F_STR(VATEntity, REGON),
+	F_STR(VATEntity, KRS),
+	F_STR(VATEntity, ResidenceAddress),
+	F_STR(VATEntity, WorkingAddress),
+	F_INT(VATEntity, VATStatus),
+	F_STR(VATEntity, VATResult),
+	F_LIST(VATEntity, Representatives, RepresentativesCount, _nip24_vatperson),
+	F_LIST(VATEntity, AuthorizedClerks, AuthorizedClerksCount, _nip24_vatperson),
+	F_LIST(VATEntity, Partners, PartnersCount, _nip24_vatperson),
+	F_STRS(VATEntity, IBANs, IBANsCount),
+	F_BOOL(VATEntity, HasVirtualAccounts),
+	F_TIME(VATEntity, RegistrationLegalDate),
+	F_TIME(VATEntity, RegistrationDenialDate),
+	F_STR(VATEntity, RegistrationDenialBasis),
+	F_TIME(VATEntity, RestorationDate),
+	F_STR(VATEntity, RestorationBasis),
+	F_TIME(VATEntity, RemovalDate),
+	F_STR(VATEntity, RemovalBasis)
+};
+
+SCHEMA(_nip24_vatentity, VATEntity);
+
+static const RecordField _nip24_invoice_fields[] = {
+	F_STR(InvoiceData, UID),
+	F_STR(InvoiceData, NIP),
+	F_STR(InvoiceData, Name),
+	F_STR(InvoiceData, FirstName),
+	F_STR(InvoiceData, LastName),
+	F_STR(InvoiceData, Street),
+	F_STR(InvoiceData, StreetNumber),
+	F_STR(InvoiceData, HouseNumber),
+	F_STR(InvoiceData, City),
+	F_STR(InvoiceData, PostCode),
+	F_STR(InvoiceData, PostCity),
+	F_STR(InvoiceData, Phone),
+	F_STR(InvoiceData, Email),
+	F_STR(InvoiceData, WWW)
+};
+
+SCHEMA(_nip24_invoice, InvoiceData);
+
+static const RecordField _nip24_all_fields[] = {
+	F_STR(AllData, UID),
+	F_STR(AllData, Type),
+	F_STR(AllData, NIP),
+	F_STR(AllData, REGON),
+	F_STR(AllData, Name),
+	F_STR(AllData, ShortName),
+	F_STR(AllData, FirstName),
+	F_STR(AllData, SecondName),
+	F_STR(AllData, LastName),
+	F_STR(AllData, Street),
+	F_STR(AllData, StreetCode),
+	F_STR(AllData, StreetNumber),
+	F_STR(AllData, HouseNumber),
+	F_STR(AllData, City),
+	F_STR(AllData, CityCode),
+	F_STR(AllData, Community),
+	F_STR(AllData, CommunityCode),
+	F_STR(AllData, County),
+	F_STR(AllData, CountyCode),
+	F_STR(AllData, State),
+	F_STR(AllData, StateCode),
+	F_STR(AllData, PostCode),
+	F_STR(AllData, PostCity),
+	F_STR(AllData, Phone),
+	F_STR(AllData, Email),
+	F_STR(AllData, WWW),
+	F_TIME(AllData, CreationDate),
+	F_TIME(AllData, StartDate),
+	F_TIME(AllData, RegistrationDate),
+	F_TIME(AllData, HoldDate),
+	F_TIME(AllData, RenevalDate),
+	F_TIME(AllData, LastUpdateDate),
+	F_TIME(AllData, BankruptcyDate),
+	F_TIME(AllData, EndOfBankruptcyProceedingsDate),
+	F_TIME(AllData, EndDate),
+	F_STR(AllData, RegistryEntityCode),
+	F_STR(AllData, RegistryEntityName),
+	F_STR(AllData, RegistryCode),
+	F_STR(AllData, RegistryName),
+	F_TIME(AllData, RecordCreationDate),
+	F_STR(AllData, RecordNumber),
+	F_STR(AllData, BasicLegalFormCode),
+	F_STR(AllData, BasicLegalFormName),
+	F_STR(AllData, SpecificLegalFormCode),
+	F_STR(AllData, SpecificLegalFormName),
+	F_STR(AllData, OwnershipFormCode),
+	F_STR(AllData, OwnershipFormName),
+	F_LIST(AllData, BusinessPartner, BusinessPartnerCount, _nip24_partner),
+	F_LIST(AllData, PKD, PKDCount, _nip24_pkd)
+};
+
+SCHEMA(_nip24_all, AllData);
+
+static const RecordField _nip24_vies_fields[] = {
+	F_STR(VIESData, UID),
+	F_STR(VIESData, CountryCode),
+	F_STR(VIESData, VATNumber),
+	F_BOOL(VIESData, Valid),
+	F_STR(VIESData, TraderName),
+	F_STR(VIESData, TraderCompanyType),
+	F_STR(VIESData, TraderAddress),
+	F_STR(VIESData, ID),
+	F_TIME(VIESData, Date),
+	F_STR(VIESData, Source)
+};
+
+SCHEMA(_nip24_vies, VIESData);
+
+static const RecordField _nip24_vat_fields[] = {
+	F_STR(VATStatus, UID),
+	F_STR(VATStatus, NIP),
+	F_STR(VATStatus, REGON),
+	F_STR(VATStatus, Name),
+	F_INT(VATStatus, Status),
+	F_STR(VATStatus, Result),
+	F_STR(VATStatus, ID),
+	F_TIME(VATStatus, Date),
+	F_STR(VATStatus, Source)
+};
+
+SCHEMA(_nip24_vat, VATStatus);
+
+static const RecordField _nip24_iban_fields[] = {
+	F_STR(IBANStatus, UID),
+	F_STR(IBANStatus, NIP),
+	F_STR(IBANStatus, REGON),
+	F_STR(IBANStatus, IBAN),
+	F_BOOL(IBANStatus, Valid),
+	F_STR(IBANStatus, ID),
+	F_TIME(IBANStatus, Date),
+	F_STR(IBANStatus, Source)
+};
+
+SCHEMA(_nip24_iban, IBANStatus);
+
+static const RecordField _nip24_wl_fields[] = {
+	F_STR(WLStatus, UID),
+	F_STR(WLStatus, NIP),
+	F_STR(WLStatus, IBAN),
+	F_BOOL(WLStatus, Valid),
+	F_BOOL(WLStatus, Virtual),
+	F_INT(WLStatus, Status),
+	F_STR(WLStatus, Result),
+	F_INT(WLStatus, HashIndex),
+	F_INT(WLStatus, MaskIndex),
+	F_TIME(WLStatus, Date),
+	F_STR(WLStatus, Source)
+};
+
+SCHEMA(_nip24_wl, WLStatus);
+
+static const RecordField _nip24_search_fields[] = {
+	F_STR(SearchResult, UID),
+	F_INT(SearchResult, ResultsType),
+	F_LIST(SearchResult, Results.VATEntity, ResultsCount, _nip24_vatentity),
+	F_STR(SearchResult, ID),
+	F_TIME(SearchResult, Date),
+	F_STR(SearchResult, Source)
+};
+
+SCHEMA(_nip24_search, SearchResult);
+
+static const RecordSchema* _nip24_record_schemas[NIP24_ENDPOINT_COUNT] = {
+	[NIP24_ENDPOINT_INVOICE] = &_nip24_invoice,
+	[NIP24_ENDPOINT_ALL] = &_nip24_all,
+	[NIP24_ENDPOINT_VIES] = &_nip24_vies,
+	[NIP24_ENDPOINT_VAT] = &_nip24_vat,
+	[NIP24_ENDPOINT_IBAN] = &_nip24_iban,
+	[NIP24_ENDPOINT_WHITELIST] = &_nip24_wl,
+	[NIP24_ENDPOINT_SEARCH] = &_nip24_search
+};
+
+/////////////////////////////////////////////////////////////////
+
+static BOOL _nip24_record_reserve(RecordBuffer* b, size_t n)
+{
+	uint8_t* data;
+	size_t size;
+
+	if (b->len + n <= b->size) {
+		return TRUE;
+	}
+
+	size = (b->size ? b->size : 256);
+
+	while (size < b->len + n) {
+		size *= 2;
+	}
+
+	if ((data = (uint8_t*)realloc(b->data, size)) == NULL) {
+		return FALSE;
+	}
+
+	b->data = data;
+	b->size = size;
+
+	return TRUE;
+}
+
+static BOOL _nip24_record_put_varint(RecordBuffer* b, uint64_t v)
+{
+	if (!_nip24_record_reserve(b, 10)) {
+		return FALSE;
+	}
+
+	while (v >= 0x80) {
+		b->data[b->len++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+
+	b->data[b->len++] = (uint8_t)v;
+
+	return TRUE;
+}
+
+static BOOL _nip24_record_put_int(RecordBuffer* b, int64_t v)
+{
+	// zigzag: male wartosci ujemne (np. -1) zajmuja jeden bajt
+	return _nip24_record_put_varint(b, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static BOOL _nip24_record_put_str(RecordBuffer* b, const char* str)
+{
+	size_t len;
+
+	// 0 - NULL, n + 1 - ciag o dlugosci n
+	if (!str) {
+		return _nip24_record_put_varint(b, 0);
+	}
+
+	len = strlen(str);
+
+	if (!_nip24_record_put_varint(b, len + 1) || !_nip24_record_reserve(b, len)) {
+		return FALSE;
+	}
+
+	memcpy(b->data + b->len, str, len);
+	b->len += len;
+
+	return TRUE;
+}
+
+static BOOL _nip24_record_encode(RecordBuffer* b, const RecordSchema* s, const void* obj)
+{
+	const RecordField* f;
+
+	int n;
+	int i;
+	int k;
+
+	for (i = 0; i < s->count; i++) {
+		f = &s->field[i];
+
+		switch (f->type) {
+		case 's':
+			if (!_nip24_record_put_str(b, *FIELD(obj, f, char*))) {
+				return FALSE;
+			}
+			break;
+
+		case 'i':
+		case 'b':
+			if (!_nip24_record_put_int(b, *FIELD(obj, f, int))) {
+				return FALSE;
+			}
+			break;
+
+		case 't':
+			if (!_nip24_record_put_int(b, *FIELD(obj, f, time_t))) {
+				return FALSE;
+			}
+			break;
+
+		case 'a':
+			n = *COUNT(obj, f);
+
+			if (!_nip24_record_put_varint(b, n)) {
+				return FALSE;
+			}
+
+			for (k = 0; k < n; k++) {
+				if (!_nip24_record_put_str(b, (*FIELD(obj, f, char**))[k])) {
+					return FALSE;
+				}
+			}
+			break;
+
+		case 'l':
+			n = *COUNT(obj, f);
+
+			if (!_nip24_record_put_varint(b, n)) {
+				return FALSE;
+			}
+
+			for (k = 0; k < n; k++) {
+				if (!_nip24_record_encode(b, f->item, (*FIELD(obj, f, void**))[k])) {
+					return FALSE;
+				}
+			}
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
+static BOOL _nip24_record_get_varint(RecordReader* r, uint64_t* v)
+{
+	int shift;
+
+	*v = 0;
+
+	for (shift = 0; r->p < r->end && shift < 64; shift += 7) {
+		*v |= (uint64_t)(*r->p & 0x7f) << shift;
+
+		if ((*r->p++ & 0x80) == 0) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static BOOL _nip24_record_get_int(RecordReader* r, int64_t* v)
+{
+	uint64_t u;
+
+	if (!_nip24_record_get_varint(r, &u)) {
+		return FALSE;
+	}
+
+	*v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+
+	return TRUE;
+}
+
+static BOOL _nip24_record_get_str(RecordReader* r, char** str)
+{
+	uint64_t len;
+
+	if (!_nip24_record_get_varint(r, &len)) {
+		return FALSE;
+	}
+
+	if (len == 0) {
+		*str = NULL;
+		return TRUE;
+	}
+
+	if (--len > (uint64_t)(r->end - r->p) || (*str = (char*)malloc((size_t)len + 1)) == NULL) {
+		return FALSE;
+	}
+
+	memcpy(*str, r->p, (size_t)len);
+	(*str)[len] = '\0';
+
+	r->p += len;
+
+	return TRUE;
+}
+
+static void _nip24_record_free(const RecordSchema* s, void* obj)
+{
+	const RecordField* f;
+
+	int i;
+	int k;
+
+	if (!obj) {
+		return;
+	}
+
+	for (i = 0; i < s->count; i++) {
+		f = &s->field[i];
+
+		switch (f->type) {
+		case 's':
+			free(*FIELD(obj, f, char*));
+			break;
+
+		case 'a':
+			for (k = 0; k < *COUNT(obj, f); k++) {
+				free((*FIELD(obj, f, char**))[k]);
+			}
+
+			free(*FIELD(obj, f, char**));
+			break;
+
+		case 'l':
+			for (k = 0; k < *COUNT(obj, f); k++) {
+				_nip24_record_free(f->item, (*FIELD(obj, f, void**))[k]);
+			}
+
+			free(*FIELD(obj, f, void**));
+			break;
+		}
+	}
+
+	free(obj);
+}
+
+static void* _nip24_record_decode(RecordReader* r, const RecordSchema* s)
+{
+	const RecordField* f;
+	void* obj;
+
+	uint64_t n;
+	int64_t v;
+
+	int i;
+	int k;
+
+	if ((obj = calloc(1, s->size)) == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < s->count; i++) {
+		f = &s->field[i];
+
+		switch (f->type) {
+		case 's':
+			if (!_nip24_record_get_str(r, FIELD(obj, f, char*))) {
+				goto err;
+			}
+			break;
+
+		case 'i':
+		case 'b':
+			if (!_nip24_record_get_int(r, &v)) {
+				goto err;
+			}
+
+			*FIELD(obj, f, int) = (int)v;
+			break;
+
+		case 't':
+			if (!_nip24_record_get_int(r, &v)) {
+				goto err;
+			}
+
+			*FIELD(obj, f, time_t) = (time_t)v;
+			break;
+
+		case 'a':
+		case 'l':
+			// kazdy element zajmuje co najmniej jeden bajt
+			if (!_nip24_record_get_varint(r, &n) || n > (uint64_t)(r->end - r->p)) {
+				goto err;
+			}
+
+			if (n == 0) {
+				break;
+			}
+
+			if ((*FIELD(obj, f, void**) = calloc((size_t)n, sizeof(void*))) == NULL) {
+				goto err;
+			}
+
+			for (k = 0; k < (int)n; k++) {
+				if (f->type == 'a') {
+					if (!_nip24_record_get_str(r, &(*FIELD(obj, f, char**))[k])) {
+						goto err;
+					}
+				}
+				else if (((*FIELD(obj, f, void**))[k] = _nip24_record_decode(r, f->item)) == NULL) {
+					goto err;
+				}
+
+				(*COUNT(obj, f))++;
+			}
+			break;
+		}
+	}
+
+	return obj;
+
+err:
+	_nip24_record_free(s, obj);
+
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////
+
+BOOL record_encode(Endpoint endpoint, const void* obj, uint8_t** data, size_t* len)
+{
+	RecordBuffer b;
+
+	memset(&b, 0, sizeof(b));
+
+	if (endpoint < 0 || endpoint >= NIP24_ENDPOINT_COUNT || !_nip24_record_schemas[endpoint] || !obj) {
+		return FALSE;
+	}
+
+	if (!_nip24_record_put_varint(&b, RECORD_VERSION)
+		|| !_nip24_record_encode(&b, _nip24_record_schemas[endpoint], obj)) {
+
+		free(b.data);
+		return FALSE;
+	}
+
+	*data = b.data;
+	*len = b.len;
+
+	return TRUE;
+}
+
+void* record_decode(Endpoint endpoint, const uint8_t* data, size_t len)
+{
+	RecordReader r;
+
+	uint64_t version;
+
+	if (endpoint < 0 || endpoint >= NIP24_ENDPOINT_COUNT || !_nip24_record_schemas[endpoint] || !data) {
+		return NULL;
+	}
+
+	r.p = data;
+	r.end = data + len;
+
+	if (!_nip24_record_get_varint(&r, &version) || version != RECORD_VERSION) {
+		return NULL;
+	}
+
+	return _nip24_record_decode(&r, _nip24_record_schemas[endpoint]);
+}
+
+BOOL record_encode_error(int code, const char* err, uint8_t** data, size_t* len)
+{
+	RecordBuffer b;
+
+	memset(&b, 0, sizeof(b));
+
+	// zamiast wersji rekord bledu zaczyna sie od znacznika RECORD_ERROR
+	if (!_nip24_record_put_varint(&b, RECORD_ERROR)
+		|| !_nip24_record_put_int(&b, code)
+		|| !_nip24_record_put_str(&b, err)) {
+
+		free(b.data);
+		return FALSE;
+	}
+
+	*data = b.data;
+	*len = b.len;
+
+	return TRUE;
+}
+
+BOOL record_decode_error(const uint8_t* data, size_t len, int* code, char** err)
+{
+	RecordReader r;
+
+	uint64_t tag;
+	int64_t v;
+
+	if (!data) {
+		return FALSE;
+	}
+
+	r.p = data;
+	r.end = data + len;
+
+	if (!_nip24_record_get_varint(&r, &tag) || tag != RECORD_ERROR) {
+		return FALSE;
+	}
+
+	if (!_nip24_record_get_int(&r, &v) || v == 0 || v != (int)v || !_nip24_record_get_str(&r, err)) {
+		return FALSE;
+	}
+
+	*code = (int)v;
+
+	return TRUE;
+}
@@ -0,0 +1,435 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define SHARED_MAGIC		0x3432504eUL
+#define SHARED_VERSION		1
+
+#define SHARED_ENTRY		1024
+#define SHARED_MIN_SLOTS	256
+#define SHARED_MIN_ARENA	(64 * 1024)
+#define SHARED_PROBE		16
+#define SHARED_SPIN			1000
+#define SHARED_WAIT			50
+
+#define SHARED_HASH(h)		((h) ? (h) : 1)
+
+/**
+ * Naglowek segmentu pamieci wspoldzielonej. Rekordy zapisywane sa cyklicznie w obszarze
+ * arena; head to bezwzgledna pozycja zapisu, wiec rekord z pozycji pos jest aktualny dopoki
+ * head - pos nie przekroczy rozmiaru obszaru (najstarsze rekordy sa nadpisywane).
+ */
+typedef struct SharedHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slots;
+	uint32_t reserved;
+	uint64_t arena;
+	volatile LONG64 head;
+} SharedHeader;
+
+/**
+ * Pozycja tablicy (adresowanie otwarte z ograniczona liczba prob). Zapisujacy zwieksza licznik
+ * seq przed i po zmianie pozycji; czytelnicy przy nieparzystej lub zmienionej wartosci
+ * powtarzaja odczyt.
+ */
+typedef struct SharedSlot {
+	volatile LONG seq;
+	uint32_t len;
+	uint64_t hash;		// 0 - pozycja wolna
+	uint64_t pos;
+	int64_t expires;	// 0 - bez czasu waznosci
+	CacheKey key;
+} SharedSlot;
+
+/**
+ * Segment otwarty w biezacym procesie
+ */
+struct CacheShared {
+	HANDLE map;
+	HANDLE mutex;
+	BOOL repair;
+
+	SharedHeader* hdr;
+	SharedSlot* slot;
+	uint8_t* arena;
+};
+
+/////////////////////////////////////////////////////////////////
+
+static LONG64 _nip24_shared_head(CacheShared* shm)
+{
+	// niepodzielny odczyt 64 bitow rowniez w procesach 32-bitowych
+	return InterlockedCompareExchange64(&shm->hdr->head, 0, 0);
+}
+
+static BOOL _nip24_shared_valid(CacheShared* shm, LONG64 head, uint64_t pos)
+{
+	return ((uint64_t)head - pos <= shm->hdr->arena);
+}
+
+static BOOL _nip24_shared_dead(CacheShared* shm, LONG64 head, SharedSlot* s, time_t now)
+{
+	return (!_nip24_shared_valid(shm, head, s->pos) || (s->expires != 0 && s->expires <= now));
+}
+
+static BOOL _nip24_shared_lock(CacheShared* shm, DWORD timeout)
+{
+	switch (WaitForSingleObject(shm->mutex, timeout)) {
+	case WAIT_OBJECT_0:
+		return TRUE;
+
+	case WAIT_ABANDONED:
+		// proces zakonczyl sie w trakcie zapisu
+		shm->repair = TRUE;
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * Zwolnienie pozycji pozostawionych w trakcie zapisu przez przerwany proces
+ */
+static void _nip24_shared_repair(CacheShared* shm)
+{
+	uint32_t i;
+
+	for (i = 0; i < shm->hdr->slots; i++) {
+		if (shm->slot[i].seq & 1) {
+			shm->slot[i].hash = 0;
+			InterlockedIncrement(&shm->slot[i].seq);
+		}
+	}
+
+	shm->repair = FALSE;
+}
+
+/**
+ * Spojna kopia pozycji odczytana bez blokady
+ */
+static BOOL _nip24_shared_copy(SharedSlot* s, SharedSlot* copy)
+{
+	LONG seq;
+	int i;
+
+	for (i = 0; i < SHARED_SPIN; i++) {
+		if ((seq = s->seq) & 1) {
+			YieldProcessor();
+			continue;
+		}
+
+		MemoryBarrier();
+		memcpy(copy, (const void*)s, sizeof(SharedSlot));
+		MemoryBarrier();
+
+		if (s->seq == seq) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void _nip24_shared_read(CacheShared* shm, uint64_t pos, uint8_t* data, size_t len)
+{
+	size_t off = (size_t)(pos % shm->hdr->arena);
+	size_t n = (size_t)(shm->hdr->arena - off);
+
+	if (n >= len) {
+		memcpy(data, shm->arena + off, len);
+	}
+	else {
+		memcpy(data, shm->arena + off, n);
+		memcpy(data + n, shm->arena, len - n);
+	}
+}
+
+static void _nip24_shared_write(CacheShared* shm, uint64_t pos, const uint8_t* data, size_t len)
+{
+	size_t off = (size_t)(pos % shm->hdr->arena);
+	size_t n = (size_t)(shm->hdr->arena - off);
+
+	if (n >= len) {
+		memcpy(shm->arena + off, data, len);
+	}
+	else {
+		memcpy(shm->arena + off, data, n);
+		memcpy(shm->arena, data + n, len - n);
+	}
+}
+
+/////////////////////////////////////////////////////////////////
+
+BOOL shared_open(CacheShared** shm, const char* name, size_t size)
+{
+	CacheShared* s = NULL;
+	SharedHeader* hdr;
+	MEMORY_BASIC_INFORMATION mbi;
+
+	char str[MAX_STRING];
+	uint64_t bytes;
+	uint32_t slots;
+
+	BOOL locked = FALSE;
+	BOOL ret = FALSE;
+
+	if (!shm || !name || strlen(name) == 0 || size < SHARED_MIN_ARENA * 2) {
+		return FALSE;
+	}
+
+	if ((s = (CacheShared*)malloc(sizeof(CacheShared))) == NULL) {
+		return FALSE;
+	}
+
+	memset(s, 0, sizeof(CacheShared));
+
+	snprintf(str, sizeof(str), "Local\\nip24-shared-%s-lock", name);
+
+	if ((s->mutex = CreateMutexA(NULL, FALSE, str)) == NULL) {
+		goto err;
+	}
+
+	if (!_nip24_shared_lock(s, INFINITE)) {
+		goto err;
+	}
+
+	locked = TRUE;
+
+	// segment w pliku wymiany istnieje dopoki jest otwarty przez co najmniej jeden proces;
+	// jezeli juz istnieje, obowiazuje rozmiar nadany przez proces, ktory go utworzyl
+	snprintf(str, sizeof(str), "Local\\nip24-shared-%s", name);
+
+	if ((s->map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32),
+		(DWORD)size, str)) == NULL) {
+		goto err;
+	}
+
+	if ((s->hdr = (SharedHeader*)MapViewOfFile(s->map, FILE_MAP_ALL_ACCESS, 0, 0, 0)) == NULL) {
+		goto err;
+	}
+
+	if (VirtualQuery(s->hdr, &mbi, sizeof(mbi)) == 0) {
+		goto err;
+	}
+
+	hdr = s->hdr;
+
+	if (hdr->magic != SHARED_MAGIC) {
+		// nowy segment jest wypelniony zerami
+		bytes = mbi.RegionSize;
+
+		for (slots = SHARED_MIN_SLOTS; (uint64_t)slots * 2 * SHARED_ENTRY <= bytes; slots *= 2);
+
+		if (sizeof(SharedHeader) + (uint64_t)slots * sizeof(SharedSlot) + SHARED_MIN_ARENA > bytes) {
+			goto err;
+		}
+
+		hdr->version = SHARED_VERSION;
+		hdr->slots = slots;
+		hdr->arena = bytes - sizeof(SharedHeader) - (uint64_t)slots * sizeof(SharedSlot);
+
+		MemoryBarrier();
+		hdr->magic = SHARED_MAGIC;
+	}
+	else if (hdr->version != SHARED_VERSION || hdr->slots == 0 || (hdr->slots & (hdr->slots - 1)) != 0
+		|| sizeof(SharedHeader) + (uint64_t)hdr->slots * sizeof(SharedSlot) + hdr->arena > mbi.RegionSize) {
+		goto err;
+	}
+
+	s->slot = (SharedSlot*)(hdr + 1);
+	s->arena = (uint8_t*)(s->slot + hdr->slots);
+
+	if (s->repair) {
+		_nip24_shared_repair(s);
+	}
+
+	// ok
+	ret = TRUE;
+
+err:
+	if (locked) {
+		ReleaseMutex(s->mutex);
+	}
+
+	if (ret) {
+		*shm = s;
+	}
+	else {
+		shared_close(&s);
+	}
+
+	return ret;
+}
+
+void shared_close(CacheShared** shm)
+{
+	CacheShared* s = (shm ? *shm : NULL);
+
+	if (!s) {
+		return;
+	}
+
+	if (s->hdr) {
+		UnmapViewOfFile(s->hdr);
+	}
+
+	if (s->map) {
+		CloseHandle(s->map);
+	}
+
+	if (s->mutex) {
+		CloseHandle(s->mutex);
+	}
+
+	free(*shm);
+	*shm = NULL;
+}
+
+BOOL shared_get(CacheShared* shm, const CacheKey* key, uint64_t hash, uint8_t** data, size_t* len, time_t* expires)
+{
+	SharedSlot s;
+
+	uint8_t* buf = NULL;
+	uint32_t mask = shm->hdr->slots - 1;
+	uint32_t i;
+
+	BOOL ret = FALSE;
+
+	hash = SHARED_HASH(hash);
+
+	for (i = 0; i < SHARED_PROBE; i++) {
+		if (!_nip24_shared_copy(&shm->slot[(hash + i) & mask], &s) || s.hash == 0) {
+			goto err;
+		}
+
+		if (s.hash == hash && memcmp(&s.key, key, sizeof(CacheKey)) == 0) {
+			break;
+		}
+	}
+
+	if (i == SHARED_PROBE || (s.expires != 0 && s.expires <= time(NULL))) {
+		goto err;
+	}
+
+	if (!_nip24_shared_valid(shm, _nip24_shared_head(shm), s.pos)) {
+		goto err;
+	}
+
+	if ((buf = (uint8_t*)malloc(s.len + 1)) == NULL) {
+		goto err;
+	}
+
+	_nip24_shared_read(shm, s.pos, buf, s.len);
+
+	// zapisujacy przesuwa head przed nadpisaniem obszaru, wiec ponowne sprawdzenie
+	// wykrywa rekord nadpisany w trakcie kopiowania
+	MemoryBarrier();
+
+	if (!_nip24_shared_valid(shm, _nip24_shared_head(shm), s.pos)) {
+		goto err;
+	}
+
+	// ok
+	*data = buf;
+	*len = s.len;
+	*expires = (time_t)s.expires;
+
+	buf = NULL;
+	ret = TRUE;
+
+err:
+	free(buf);
+
+	return ret;
+}
+
+BOOL shared_put(CacheShared* shm, const CacheKey* key, uint64_t hash, const uint8_t* data, size_t len, time_t expires)
+{
+	SharedSlot* s;
+	SharedSlot* victim = NULL;
+
+	uint32_t mask = shm->hdr->slots - 1;
+	uint32_t i;
+
+	LONG64 head;
+	time_t now = time(NULL);
+
+	// pojedynczy rekord nie moze zajac wiecej niz czesci obszaru
+	if (len > shm->hdr->arena / 4) {
+		return FALSE;
+	}
+
+	hash = SHARED_HASH(hash);
+
+	// zapis jest opcjonalny, wiec nie czeka na inne procesy
+	if (!_nip24_shared_lock(shm, SHARED_WAIT)) {
+		return FALSE;
+	}
+
+	if (shm->repair) {
+		_nip24_shared_repair(shm);
+	}
+
+	head = shm->hdr->head;
+
+	// pozycja z tym samym kluczem, wolna, nieaktualna lub najstarsza w zasiegu prob
+	for (i = 0; i < SHARED_PROBE; i++) {
+		s = &shm->slot[(hash + i) & mask];
+
+		if (s->hash == 0 || (s->hash == hash && memcmp(&s->key, key, sizeof(CacheKey)) == 0)) {
+			victim = s;
+			break;
+		}
+
+		if (_nip24_shared_dead(shm, head, s, now)) {
+			if (!victim || !_nip24_shared_dead(shm, head, victim, now)) {
+				victim = s;
+			}
+		}
+		else if (!victim || (!_nip24_shared_dead(shm, head, victim, now) && s->pos < victim->pos)) {
+			victim = s;
+		}
+	}
+
+	// rezerwacja obszaru przed jego nadpisaniem (patrz shared_get)
+	InterlockedExchange64(&shm->hdr->head, head + (LONG64)len);
+	MemoryBarrier();
+
+	_nip24_shared_write(shm, (uint64_t)head, data, len);
+
+	InterlockedIncrement(&victim->seq);
+
+	victim->len = (uint32_t)len;
+	victim->hash = hash;
+	victim->pos = (uint64_t)head;
+	victim->expires = (int64_t)expires;
+	victim->key = *key;
+
+	InterlockedIncrement(&victim->seq);
+
+	ReleaseMutex(shm->mutex);
+
+	return TRUE;
+}
@@ -0,0 +1,883 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "internal.h"
+#include "nip24.h"
+
+
+#define STORE_MAGIC			0x3432504eUL
+#define STORE_VERSION		1
+
+#define STORE_SLOTS			65536
+#define STORE_MAX_RECORD	(16 * 1024 * 1024)
+#define STORE_MIN_GARBAGE	(1024 * 1024)
+#define STORE_SPIN			1000
+#define STORE_KEEP			16
+
+#define STORE_WAIT			100
+#define STORE_COMPACT_WAIT	5000
+#define STORE_INTERVAL		60000
+
+#define STORE_HASH(h)		((h) ? (h) : 1)
+
+/**
+ * Plik kontrolny magazynu: numer aktualnej generacji plikow indeksu i danych
+ */
+typedef struct StoreControl {
+	uint32_t magic;
+	uint32_t version;
+	volatile LONG generation;
+} StoreControl;
+
+/**
+ * Naglowek pliku indeksu
+ */
+typedef struct StoreHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slots;
+	uint32_t used;
+	uint64_t size;		// koniec zapisanych rekordow w pliku danych
+	uint64_t garbage;	// bajty rekordow zastapionych nowszymi
+} StoreHeader;
+
+/**
+ * Pozycja indeksu (adresowanie otwarte, bez usuwania - wygasle pozycje znikaja przy kompaktowaniu).
+ * Zapisujacy zwieksza licznik seq przed i po zmianie pozycji; czytelnicy nie blokuja sie,
+ * a przy nieparzystej lub zmienionej wartosci licznika powtarzaja odczyt.
+ */
+typedef struct StoreSlot {
+	volatile LONG seq;
+	uint32_t len;
+	uint64_t hash;		// 0 - pozycja wolna
+	uint64_t offset;
+	int64_t expires;	// 0 - bez czasu waznosci
+	CacheKey key;
+} StoreSlot;
+
+/**
+ * Naglowek rekordu w pliku danych (rekord zakodowany przez record.c)
+ */
+typedef struct StoreRecord {
+	uint32_t len;
+	uint32_t check;
+} StoreRecord;
+
+/**
+ * Otwarta generacja plikow; zamykana po zwolnieniu ostatniej referencji
+ */
+typedef struct StoreGen {
+	volatile LONG refs;
+	LONG number;
+
+	HANDLE idx;
+	HANDLE map;
+	HANDLE dat;
+
+	StoreHeader* hdr;
+	StoreSlot* slot;
+} StoreGen;
+
+/**
+ * Trwaly magazyn odpowiedzi: pliki <path>.ctl, <path>.<generacja>.idx i <path>.<generacja>.dat.
+ * Zapisy (rowniez z innych procesow) szeregowane sa nazwanym mutexem, odczyty sa bez blokad.
+ */
+struct CacheStore {
+	char path[MAX_PATH];
+
+	HANDLE mutex;
+	BOOL repair;
+
+	HANDLE ctl;
+	HANDLE ctl_map;
+	StoreControl* control;
+
+	CRITICAL_SECTION lock;
+	StoreGen* current;
+
+	HANDLE thread;
+	HANDLE stop;
+	HANDLE wake;
+};
+
+/////////////////////////////////////////////////////////////////
+
+static uint32_t _nip24_store_check(const uint8_t* data, size_t len)
+{
+	uint32_t h = 2166136261UL;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h = (h ^ data[i]) * 16777619UL;
+	}
+
+	return h;
+}
+
+static uint64_t _nip24_store_name(const char* path)
+{
+	uint64_t h = 14695981039346656037ULL;
+
+	// sciezki w Windows nie rozrozniaja wielkosci liter
+	for (; *path; path++) {
+		h = (h ^ (uint8_t)tolower((unsigned char)*path)) * 1099511628211ULL;
+	}
+
+	return h;
+}
+
+static void _nip24_store_path(CacheStore* store, LONG number, const char* ext, char* path)
+{
+	snprintf(path, MAX_PATH, "%s.%ld.%s", store->path, number, ext);
+}
+
+static BOOL _nip24_store_read(HANDLE file, uint64_t offset, void* data, size_t len)
+{
+	OVERLAPPED ov;
+	DWORD n;
+
+	memset(&ov, 0, sizeof(OVERLAPPED));
+
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+
+	return (ReadFile(file, data, (DWORD)len, &n, &ov) && n == len);
+}
+
+static BOOL _nip24_store_write(HANDLE file, uint64_t offset, const void* data, size_t len)
+{
+	OVERLAPPED ov;
+	DWORD n;
+
+	memset(&ov, 0, sizeof(OVERLAPPED));
+
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+
+	return (WriteFile(file, data, (DWORD)len, &n, &ov) && n == len);
+}
+
+static void _nip24_store_gen_free(StoreGen* gen)
+{
+	if (!gen) {
+		return;
+	}
+
+	if (gen->hdr) {
+		UnmapViewOfFile(gen->hdr);
+	}
+
+	if (gen->map) {
+		CloseHandle(gen->map);
+	}
+
+	if (gen->idx != INVALID_HANDLE_VALUE) {
+		CloseHandle(gen->idx);
+	}
+
+	if (gen->dat != INVALID_HANDLE_VALUE) {
+		CloseHandle(gen->dat);
+	}
+
+	free(gen);
+}
+
+static void _nip24_store_gen_delete(CacheStore* store, LONG number)
+{
+	char path[MAX_PATH];
+
+	// pliki otwarte przez inne procesy zostana usuniete po ich zamknieciu
+	_nip24_store_path(store, number, "idx", path);
+	DeleteFileA(path);
+
+	_nip24_store_path(store, number, "dat", path);
+	DeleteFileA(path);
+}
+
+/**
+ * Otwarcie istniejacej generacji (slots = 0) lub utworzenie nowej, pustej
+ */
+static StoreGen* _nip24_store_gen_open(CacheStore* store, LONG number, uint32_t slots)
+{
+	StoreGen* gen = NULL;
+	LARGE_INTEGER size;
+
+	char path[MAX_PATH];
+
+	DWORD mode = (slots ? CREATE_ALWAYS : OPEN_EXISTING);
+	DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+
+	BOOL ok = FALSE;
+
+	if ((gen = (StoreGen*)malloc(sizeof(StoreGen))) == NULL) {
+		goto err;
+	}
+
+	memset(gen, 0, sizeof(StoreGen));
+
+	gen->refs = 1;
+	gen->number = number;
+	gen->idx = INVALID_HANDLE_VALUE;
+	gen->dat = INVALID_HANDLE_VALUE;
+
+	_nip24_store_path(store, number, "dat", path);
+
+	if ((gen->dat = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, share, NULL, mode,
+		FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE) {
+		goto err;
+	}
+
+	_nip24_store_path(store, number, "idx", path);
+
+	if ((gen->idx = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, share, NULL, mode,
+		FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE) {
+		goto err;
+	}
+
+	if (slots) {
+		size.QuadPart = (LONGLONG)sizeof(StoreHeader) + (LONGLONG)slots * (LONGLONG)sizeof(StoreSlot);
+	}
+	else if (!GetFileSizeEx(gen->idx, &size) || size.QuadPart < (LONGLONG)sizeof(StoreHeader)) {
+		goto err;
+	}
+
+	if ((gen->map = CreateFileMappingA(gen->idx, NULL, PAGE_READWRITE, (DWORD)(size.QuadPart >> 32),
+		(DWORD)size.QuadPart, NULL)) == NULL) {
+		goto err;
+	}
+
+	if ((gen->hdr = (StoreHeader*)MapViewOfFile(gen->map, FILE_MAP_ALL_ACCESS, 0, 0, 0)) == NULL) {
+		goto err;
+	}
+
+	gen->slot = (StoreSlot*)(gen->hdr + 1);
+
+	if (slots) {
+		// powiekszony plik jest wypelniony zerami, wszystkie pozycje sa wolne
+		gen->hdr->magic = STORE_MAGIC;
+		gen->hdr->version = STORE_VERSION;
+		gen->hdr->slots = slots;
+	}
+	else {
+		slots = gen->hdr->slots;
+
+		if (gen->hdr->magic != STORE_MAGIC || gen->hdr->version != STORE_VERSION
+			|| slots == 0 || (slots & (slots - 1)) != 0
+			|| size.QuadPart < (LONGLONG)sizeof(StoreHeader) + (LONGLONG)slots * (LONGLONG)sizeof(StoreSlot)) {
+			goto err;
+		}
+	}
+
+	ok = TRUE;
+
+err:
+	if (!ok) {
+		_nip24_store_gen_free(gen);
+		gen = NULL;
+	}
+
+	return gen;
+}
+
+static void _nip24_store_release(StoreGen* gen)
+{
+	if (gen && InterlockedDecrement(&gen->refs) == 0) {
+		_nip24_store_gen_free(gen);
+	}
+}
+
+/**
+ * Referencja do aktualnej generacji; po kompaktowaniu przez inny proces otwierana jest nowa
+ */
+static StoreGen* _nip24_store_acquire(CacheStore* store)
+{
+	StoreGen* gen;
+
+	LONG number = store->control->generation;
+
+	EnterCriticalSection(&store->lock);
+
+	if (store->current->number != number) {
+		if ((gen = _nip24_store_gen_open(store, number, 0)) != NULL) {
+			_nip24_store_release(store->current);
+			store->current = gen;
+		}
+	}
+
+	gen = store->current;
+	InterlockedIncrement(&gen->refs);
+
+	LeaveCriticalSection(&store->lock);
+
+	return gen;
+}
+
+static void _nip24_store_switch(CacheStore* store, StoreGen* gen)
+{
+	EnterCriticalSection(&store->lock);
+
+	_nip24_store_release(store->current);
+	store->current = gen;
+
+	LeaveCriticalSection(&store->lock);
+}
+
+static BOOL _nip24_store_lock(CacheStore* store, DWORD timeout)
+{
+	switch (WaitForSingleObject(store->mutex, timeout)) {
+	case WAIT_OBJECT_0:
+		return TRUE;
+
+	case WAIT_ABANDONED:
+		// proces zakonczyl sie w trakcie zapisu
+		store->repair = TRUE;
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * Odblokowanie pozycji pozostawionych w trakcie zapisu przez przerwany proces. Ich rekordy
+ * moga byc niespojne, ale odczyt weryfikuje dlugosc i sume kontrolna rekordu.
+ */
+static void _nip24_store_repair(CacheStore* store, StoreGen* gen)
+{
+	uint32_t i;
+
+	for (i = 0; i < gen->hdr->slots; i++) {
+		if (gen->slot[i].seq & 1) {
+			InterlockedIncrement(&gen->slot[i].seq);
+		}
+	}
+
+	store->repair = FALSE;
+}
+
+/**
+ * Pozycja z danym kluczem lub pierwsza wolna (tylko przy zablokowanym mutexie)
+ */
+static StoreSlot* _nip24_store_find(StoreGen* gen, const CacheKey* key, uint64_t hash)
+{
+	StoreSlot* s;
+
+	uint32_t mask = gen->hdr->slots - 1;
+	uint32_t i;
+
+	for (i = 0; i <= mask; i++) {
+		s = &gen->slot[(hash + i) & mask];
+
+		if (s->hash == 0 || (s->hash == hash && memcmp(&s->key, key, sizeof(CacheKey)) == 0)) {
+			return s;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Spojna kopia pozycji odczytana bez blokady
+ */
+static BOOL _nip24_store_copy(StoreSlot* s, StoreSlot* copy)
+{
+	LONG seq;
+	int i;
+
+	for (i = 0; i < STORE_SPIN; i++) {
+		if ((seq = s->seq) & 1) {
+			YieldProcessor();
+			continue;
+		}
+
+		MemoryBarrier();
+		memcpy(copy, (const void*)s, sizeof(StoreSlot));
+		MemoryBarrier();
+
+		if (s->seq == seq) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static BOOL _nip24_store_lookup(StoreGen* gen, const CacheKey* key, uint64_t hash, StoreSlot* copy)
+{
+	uint32_t mask = gen->hdr->slots - 1;
+	uint32_t i;
+
+	for (i = 0; i <= mask; i++) {
+		if (!_nip24_store_copy(&gen->slot[(hash + i) & mask], copy) || copy->hash == 0) {
+			return FALSE;
+		}
+
+		if (copy->hash == hash && memcmp(&copy->key, key, sizeof(CacheKey)) == 0) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Przepisanie aktualnych rekordow do nowej generacji i jej udostepnienie. Wykonywane gdy indeks
+ * jest zapelniony w polowie lub gdy wiecej niz polowe pliku danych zajmuja rekordy nieaktualne.
+ */
+static void _nip24_store_compact(CacheStore* store)
+{
+	StoreGen* gen = NULL;
+	StoreGen* next = NULL;
+	StoreSlot* s;
+	StoreSlot* d;
+	StoreRecord rec;
+
+	uint8_t* buf = NULL;
+	uint8_t* tmp;
+	size_t cap = 0;
+	size_t size;
+
+	uint64_t dead;
+	uint32_t count = 0;
+	uint32_t slots;
+	uint32_t i;
+
+	time_t now = time(NULL);
+	LONG old = 0;
+
+	if (!_nip24_store_lock(store, STORE_COMPACT_WAIT)) {
+		return;
+	}
+
+	gen = _nip24_store_acquire(store);
+
+	if (store->repair) {
+		_nip24_store_repair(store, gen);
+	}
+
+	dead = gen->hdr->garbage;
+
+	for (i = 0; i < gen->hdr->slots; i++) {
+		s = &gen->slot[i];
+
+		if (s->hash == 0) {
+			continue;
+		}
+
+		if (s->expires != 0 && s->expires <= now) {
+			dead += sizeof(StoreRecord) + s->len;
+		}
+		else {
+			count++;
+		}
+	}
+
+	if ((uint64_t)gen->hdr->used * 2 <= gen->hdr->slots
+		&& (dead < STORE_MIN_GARBAGE || dead * 2 <= gen->hdr->size)) {
+		goto err;
+	}
+
+	for (slots = STORE_SLOTS; (uint64_t)count * 4 > slots; slots *= 2);
+
+	if ((next = _nip24_store_gen_open(store, gen->number + 1, slots)) == NULL) {
+		goto err;
+	}
+
+	for (i = 0; i < gen->hdr->slots; i++) {
+		s = &gen->slot[i];
+
+		if (s->hash == 0 || (s->expires != 0 && s->expires <= now)) {
+			continue;
+		}
+
+		size = sizeof(StoreRecord) + s->len;
+
+		if (size > cap) {
+			if ((tmp = (uint8_t*)realloc(buf, size)) == NULL) {
+				goto err;
+			}
+
+			buf = tmp;
+			cap = size;
+		}
+
+		if (!_nip24_store_read(gen->dat, s->offset, buf, size)) {
+			continue;
+		}
+
+		memcpy(&rec, buf, sizeof(StoreRecord));
+
+		// uszkodzone rekordy sa pomijane
+		if (rec.len != s->len || rec.check != _nip24_store_check(buf + sizeof(StoreRecord), rec.len)) {
+			continue;
+		}
+
+		if (!_nip24_store_write(next->dat, next->hdr->size, buf, size)) {
+			goto err;
+		}
+
+		d = _nip24_store_find(next, &s->key, s->hash);
+
+		memcpy(d, s, sizeof(StoreSlot));
+
+		d->seq = 0;
+		d->offset = next->hdr->size;
+
+		next->hdr->size += size;
+		next->hdr->used++;
+	}
+
+	// nowa generacja musi byc zapisana na dysku zanim zostanie wskazana w pliku kontrolnym
+	if (!FlushFileBuffers(next->dat) || !FlushViewOfFile(next->hdr, 0)) {
+		goto err;
+	}
+
+	InterlockedExchange(&store->control->generation, next->number);
+
+	old = gen->number;
+
+	_nip24_store_switch(store, next);
+	next = NULL;
+
+err:
+	if (next) {
+		_nip24_store_gen_free(next);
+		_nip24_store_gen_delete(store, gen->number + 1);
+	}
+
+	free(buf);
+
+	_nip24_store_release(gen);
+
+	ReleaseMutex(store->mutex);
+
+	if (old) {
+		_nip24_store_gen_delete(store, old);
+	}
+}
+
+static DWORD WINAPI _nip24_store_worker(LPVOID param)
+{
+	CacheStore* store = (CacheStore*)param;
+	HANDLE ev[2] = { store->stop, store->wake };
+
+	while (WaitForMultipleObjects(2, ev, FALSE, STORE_INTERVAL) != WAIT_OBJECT_0) {
+		_nip24_store_compact(store);
+	}
+
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////
+
+BOOL store_open(CacheStore** store, const char* path)
+{
+	CacheStore* s = NULL;
+
+	char full[MAX_PATH];
+	char name[MAX_PATH];
+	DWORD len;
+	LONG number;
+	LONG i;
+
+	BOOL locked = FALSE;
+	BOOL ret = FALSE;
+
+	if (!store || !path) {
+		return FALSE;
+	}
+
+	// nazwa mutexu wynika z pelnej sciezki, wiec jest wspolna dla wszystkich procesow
+	if ((len = GetFullPathNameA(path, sizeof(full) - 16, full, NULL)) == 0 || len >= sizeof(full) - 16) {
+		return FALSE;
+	}
+
+	if ((s = (CacheStore*)malloc(sizeof(CacheStore))) == NULL) {
+		return FALSE;
+	}
+
+	memset(s, 0, sizeof(CacheStore));
+
+	InitializeCriticalSection(&s->lock);
+
+	s->ctl = INVALID_HANDLE_VALUE;
+	strcpy(s->path, full);
+
+	snprintf(name, sizeof(name), "Local\\nip24-store-%016" PRIx64, _nip24_store_name(full));
+
+	if ((s->mutex = CreateMutexA(NULL, FALSE, name)) == NULL) {
+		goto err;
+	}
+
+	if (!_nip24_store_lock(s, INFINITE)) {
+		goto err;
+	}
+
+	locked = TRUE;
+
+	snprintf(name, sizeof(name), "%s.ctl", full);
+
+	if ((s->ctl = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE) {
+		goto err;
+	}
+
+	if ((s->ctl_map = CreateFileMappingA(s->ctl, NULL, PAGE_READWRITE, 0, sizeof(StoreControl), NULL)) == NULL) {
+		goto err;
+	}
+
+	if ((s->control = (StoreControl*)MapViewOfFile(s->ctl_map, FILE_MAP_ALL_ACCESS, 0, 0, 0)) == NULL) {
+		goto err;
+	}
+
+	if (s->control->magic == STORE_MAGIC && s->control->version == STORE_VERSION) {
+		s->current = _nip24_store_gen_open(s, s->control->generation, 0);
+	}
+
+	if (!s->current) {
+		// nowy magazyn, inna wersja lub usuniete pliki - zaczynamy od pustej generacji
+		number = (s->control->magic == STORE_MAGIC && s->control->generation > 0 ? s->control->generation + 1 : 1);
+
+		if ((s->current = _nip24_store_gen_open(s, number, STORE_SLOTS)) == NULL) {
+			goto err;
+		}
+
+		s->control->magic = STORE_MAGIC;
+		s->control->version = STORE_VERSION;
+
+		InterlockedExchange(&s->control->generation, number);
+	}
+
+	if (s->repair) {
+		_nip24_store_repair(s, s->current);
+	}
+
+	// pozostalosci po generacjach, ktorych nie mozna bylo usunac przy kompaktowaniu
+	for (i = s->current->number - 1; i > 0 && i >= s->current->number - STORE_KEEP; i--) {
+		_nip24_store_gen_delete(s, i);
+	}
+
+	if ((s->stop = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL) {
+		goto err;
+	}
+
+	if ((s->wake = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL) {
+		goto err;
+	}
+
+	if ((s->thread = CreateThread(NULL, 0, _nip24_store_worker, s, 0, NULL)) == NULL) {
+		goto err;
+	}
+
+	// ok
+	ret = TRUE;
+
+err:
+	if (locked) {
+		ReleaseMutex(s->mutex);
+	}
+
+	if (ret) {
+		*store = s;
+	}
+	else {
+		store_close(&s);
+	}
+
+	return ret;
+}
+
+void store_close(CacheStore** store)
+{
+	CacheStore* s = (store ? *store : NULL);
+
+	if (!s) {
+		return;
+	}
+
+	if (s->thread) {
+		SetEvent(s->stop);
+		WaitForSingleObject(s->thread, INFINITE);
+		CloseHandle(s->thread);
+	}
+
+	if (s->stop) {
+		CloseHandle(s->stop);
+	}
+
+	if (s->wake) {
+		CloseHandle(s->wake);
+	}
+
+	_nip24_store_release(s->current);
+
+	if (s->control) {
+		UnmapViewOfFile(s->control);
+	}
+
+	if (s->ctl_map) {
+		CloseHandle(s->ctl_map);
+	}
+
+	if (s->ctl != INVALID_HANDLE_VALUE) {
+		CloseHandle(s->ctl);
+	}
+
+	if (s->mutex) {
+		CloseHandle(s->mutex);
+	}
+
+	DeleteCriticalSection(&s->lock);
+
+	free(*store);
+	*store = NULL;
+}
+
+BOOL store_get(CacheStore* store, const CacheKey* key, uint64_t hash, uint8_t** data, size_t* len, time_t* expires)
+{
+	StoreGen* gen;
+	StoreSlot s;
+	StoreRecord rec;
+
+	uint8_t* buf = NULL;
+
+	BOOL ret = FALSE;
+
+	gen = _nip24_store_acquire(store);
+
+	if (!_nip24_store_lookup(gen, key, STORE_HASH(hash), &s)) {
+		goto err;
+	}
+
+	if (s.expires != 0 && s.expires <= time(NULL)) {
+		goto err;
+	}
+
+	// odczytywany jest tylko rekord wskazany w indeksie
+	if (!_nip24_store_read(gen->dat, s.offset, &rec, sizeof(StoreRecord)) || rec.len != s.len) {
+		goto err;
+	}
+
+	if ((buf = (uint8_t*)malloc(rec.len + 1)) == NULL) {
+		goto err;
+	}
+
+	if (!_nip24_store_read(gen->dat, s.offset + sizeof(StoreRecord), buf, rec.len)
+		|| _nip24_store_check(buf, rec.len) != rec.check) {
+		goto err;
+	}
+
+	// ok
+	*data = buf;
+	*len = rec.len;
+	*expires = (time_t)s.expires;
+
+	buf = NULL;
+	ret = TRUE;
+
+err:
+	free(buf);
+
+	_nip24_store_release(gen);
+
+	return ret;
+}
+
+BOOL store_put(CacheStore* store, const CacheKey* key, uint64_t hash, const uint8_t* data, size_t len, time_t expires)
+{
+	StoreGen* gen;
+	StoreSlot* s;
+	StoreRecord rec;
+
+	uint64_t offset;
+
+	BOOL ret = FALSE;
+
+	if (len > STORE_MAX_RECORD) {
+		return FALSE;
+	}
+
+	hash = STORE_HASH(hash);
+
+	// zapis jest opcjonalny, wiec nie czeka na zakonczenie kompaktowania
+	if (!_nip24_store_lock(store, STORE_WAIT)) {
+		return FALSE;
+	}
+
+	gen = _nip24_store_acquire(store);
+
+	if (store->repair) {
+		_nip24_store_repair(store, gen);
+	}
+
+	if ((s = _nip24_store_find(gen, key, hash)) == NULL) {
+		goto err;
+	}
+
+	if (s->hash == 0 && ((uint64_t)gen->hdr->used + 1) * 4 > (uint64_t)gen->hdr->slots * 3) {
+		// indeks wymaga przepisania do wiekszego pliku
+		SetEvent(store->wake);
+		goto err;
+	}
+
+	// rekord jest zapisywany na koncu pliku przed udostepnieniem go w indeksie
+	offset = gen->hdr->size;
+
+	rec.len = (uint32_t)len;
+	rec.check = _nip24_store_check(data, len);
+
+	if (!_nip24_store_write(gen->dat, offset, &rec, sizeof(StoreRecord))
+		|| !_nip24_store_write(gen->dat, offset + sizeof(StoreRecord), data, len)) {
+		goto err;
+	}
+
+	if (s->hash != 0) {
+		gen->hdr->garbage += sizeof(StoreRecord) + s->len;
+	}
+	else {
+		gen->hdr->used++;
+	}
+
+	InterlockedIncrement(&s->seq);
+
+	s->len = (uint32_t)len;
+	s->hash = hash;
+	s->offset = offset;
+	s->expires = (int64_t)expires;
+	s->key = *key;
+
+	InterlockedIncrement(&s->seq);
+
+	gen->hdr->size = offset + sizeof(StoreRecord) + len;
+
+	if ((uint64_t)gen->hdr->used * 2 > gen->hdr->slots
+		|| (gen->hdr->garbage >= STORE_MIN_GARBAGE && gen->hdr->garbage * 2 > gen->hdr->size)) {
+		SetEvent(store->wake);
+	}
+
+	ret = TRUE;
+
+err:
+	_nip24_store_release(gen);
+
+	ReleaseMutex(store->mutex);
+
+	return ret;
+}
@@ -21,62 +21,47 @@
 #include "internal.h"
 #include "nip24.h"
 
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
-#define CHAR2NUM(c)		((c) - 48)
-
-static BOOL _nip24_regon_is_valid_R9(const char* regon)
-{
-	int w[] = {
-		8, 9, 2, 3, 4, 5, 6, 7
-	};
-
-	int wlen = 8;
-	int sum = 0;
-	int i;
-
-	for (i = 0; i < wlen; i++) {
-		sum += CHAR2NUM(regon[i]) * w[i];
-	}
-
-	sum %= 11;
-
-	if (sum == 10) {
-		sum = 0;
-	}
 
-	if (sum != CHAR2NUM(regon[8])) {
-		return FALSE;
-	}
-
-	return TRUE;
-}
-
-static BOOL _nip24_regon_is_valid_R14(const char* regon)
-{
-	int w[] = {
-		2, 4, 8, 5, 0, 9, 7, 3, 6, 1, 2, 4, 8
-	};
-
-	int wlen = 13;
-	int sum = 0;
-	int i;
-
-	for (i = 0; i < wlen; i++) {
-		sum += CHAR2NUM(regon[i]) * w[i];
-	}
+#define CHAR2NUM(c)		((c) - 48)
 
-	sum %= 11;
+/**
+ * Weryfikacja krajowych cyfr kontrolnych BBAN (numer IBAN bez pierwszych 4 znakow)
+ */
+typedef BOOL (*BBANChecksum)(const char* bban, int len);
 
-	if (sum == 10) {
-		sum = 0;
-	}
+/**
+ * Format numeru IBAN dla kraju: dlugosc calkowita, kolejne ciagi znakow od pozycji 2
+ * i opcjonalny algorytm krajowych cyfr kontrolnych
+ */
+typedef struct IBANFormat {
+	unsigned char length;
+	FormatRun run[RUNS_MAX];
+	BBANChecksum national;
+} IBANFormat;
 
-	if (sum != CHAR2NUM(regon[13])) {
-		return FALSE;
-	}
+/**
+ * Weryfikacja cyfr kontrolnych czesci krajowej numeru EU VAT ID (bez kodu kraju)
+ */
+typedef BOOL (*EUVATChecksum)(const char* num, int len);
 
-	return TRUE;
-}
+/**
+ * Format numeru EU VAT ID dla kraju: dopuszczalna dlugosc calkowita, dozwolone znaki
+ * na pozycji 2 (lub NULL), kolejne ciagi znakow oraz algorytm cyfr kontrolnych (ambiguous
+ * - algorytm nie obejmuje wszystkich rodzajow numerow w danym kraju)
+ */
+typedef struct EUVATFormat {
+	unsigned char min;
+	unsigned char max;
+	const char* prefix;
+	FormatRun run[RUNS_MAX];
+	BOOL ambiguous;
+	EUVATChecksum checksum;
+} EUVATFormat;
 
 static BOOL _nip24_isdigit(char* str, int start, int count)
 {
@@ -130,40 +115,51 @@ static BOOL _nip24_isalnum_ext(char* str, int start, int count)
 	return TRUE;
 }
 
-/////////////////////////////////////////////////////////////////
-
-NIP24_API char* nip24_nip_normalize(const char* nip)
+static BOOL _nip24_check_runs(char* str, int start, const FormatRun* run, int count, int var)
 {
-	char num[MAX_NUMBER];
-
-	int len;
-	int p;
+	int n;
 	int i;
 
-	if (!nip || (len = (int)strlen(nip)) < 10 || len > 13) {
-		return NULL;
-	}
-
-	// [0-9]{10}
-	memset(num, 0, sizeof(num));
-
-	for (i = 0, p = 0; i < len; i++) {
-		if (isdigit(nip[i])) {
-			num[p++] = nip[i];
+	for (i = 0; i < count && run[i].count > 0; i++) {
+		n = (run[i].count == RUN_VAR ? var : run[i].count);
+
+		switch (run[i].type) {
+		case 'n':
+			if (!_nip24_isdigit(str, start, n)) {
+				return FALSE;
+			}
+			break;
+
+		case 'a':
+			if (!_nip24_isalpha(str, start, n)) {
+				return FALSE;
+			}
+			break;
+
+		case 'c':
+			if (!_nip24_isalnum(str, start, n)) {
+				return FALSE;
+			}
+			break;
+
+		case 'x':
+			if (!_nip24_isalnum_ext(str, start, n)) {
+				return FALSE;
+			}
+			break;
+
+		default:
+			return FALSE;
 		}
-	}
 
-	if (strlen(num) != 10) {
-		return NULL;
+		start += n;
 	}
 
-	return strdup(num);
+	return TRUE;
 }
 
-NIP24_API BOOL nip24_nip_is_valid(const char* nip)
+static BOOL _nip24_nip_is_valid(const char* num)
 {
-	char* num = nip24_nip_normalize(nip);
-
 	int w[] = {
 		6, 5, 7, 2, 3, 4, 5, 6, 7
 	};
@@ -172,10 +168,6 @@ NIP24_API BOOL nip24_nip_is_valid(const char* nip)
 	int sum = 0;
 	int i;
 
-	if (!num) {
-		return FALSE;
-	}
-
 	for (i = 0; i < wlen; i++) {
 		sum += CHAR2NUM(num[i]) * w[i];
 	}
@@ -183,1295 +175,1467 @@ NIP24_API BOOL nip24_nip_is_valid(const char* nip)
 	sum %= 11;
 
 	if (sum != CHAR2NUM(num[9])) {
-		free(num);
 		return FALSE;
 	}
 
-	free(num);
-
 	return TRUE;
 }
 
-NIP24_API char* nip24_regon_normalize(const char* regon)
+static BOOL _nip24_nip_check(const char* nip, char* out, size_t size)
 {
-	char num[MAX_NUMBER];
+	int w[] = {
+		6, 5, 7, 2, 3, 4, 5, 6, 7
+	};
 
+	int sum = 0;
 	int len;
 	int p;
 	int i;
 
-	if (!regon || (len = (int)strlen(regon)) < 9 || len > 14) {
-		return NULL;
+	if (!nip || !out || size < 11 || (len = (int)strlen(nip)) < 10 || len > 13) {
+		return FALSE;
 	}
 
-	// [0-9]{9,14}
-	memset(num, 0, sizeof(num));
-
+	// [0-9]{10}, suma kontrolna liczona w trakcie normalizacji
 	for (i = 0, p = 0; i < len; i++) {
-		if (isdigit(regon[i])) {
-			num[p++] = regon[i];
+		if (isdigit(nip[i])) {
+			if (p == 10) {
+				return FALSE;
+			}
+
+			if (p < 9) {
+				sum += CHAR2NUM(nip[i]) * w[p];
+			}
+
+			out[p++] = nip[i];
 		}
 	}
 
-	if (strlen(num) != 9 && strlen(num) != 14) {
-		return NULL;
+	if (p != 10 || (sum % 11) != CHAR2NUM(out[9])) {
+		return FALSE;
 	}
 
-	return strdup(num);
+	out[p] = '\0';
+
+	return TRUE;
 }
 
-NIP24_API BOOL nip24_regon_is_valid(const char* regon)
+static BOOL _nip24_regon_check(const char* regon, char* out, size_t size)
 {
-	BOOL ret;
+	int w9[] = {
+		8, 9, 2, 3, 4, 5, 6, 7
+	};
+
+	int w14[] = {
+		2, 4, 8, 5, 0, 9, 7, 3, 6, 1, 2, 4, 8
+	};
 
-	char* num = nip24_regon_normalize(regon);
+	int sum9 = 0;
+	int sum14 = 0;
+	int len;
+	int p;
+	int i;
 
-	if (!num) {
+	if (!regon || !out || size < 15 || (len = (int)strlen(regon)) < 9 || len > 14) {
 		return FALSE;
 	}
 
-	if (strlen(num) == 9) {
-		ret = _nip24_regon_is_valid_R9(num);
-		free(num);
+	// [0-9]{9,14}, obie sumy kontrolne liczone w trakcie normalizacji
+	for (i = 0, p = 0; i < len; i++) {
+		if (isdigit(regon[i])) {
+			if (p < 8) {
+				sum9 += CHAR2NUM(regon[i]) * w9[p];
+			}
 
-		return ret;
-	}
-	else {
-		ret = _nip24_regon_is_valid_R9(num);
+			if (p < 13) {
+				sum14 += CHAR2NUM(regon[i]) * w14[p];
+			}
 
-		if (!ret) {
-			free(num);
-			return FALSE;
+			out[p++] = regon[i];
 		}
+	}
+
+	if (p != 9 && p != 14) {
+		return FALSE;
+	}
 
-		ret = _nip24_regon_is_valid_R14(num);
-		free(num);
+	if ((sum9 % 11) % 10 != CHAR2NUM(out[8])) {
+		return FALSE;
+	}
 
-		return ret;
+	if (p == 14 && (sum14 % 11) % 10 != CHAR2NUM(out[13])) {
+		return FALSE;
 	}
+
+	out[p] = '\0';
+
+	return TRUE;
 }
 
-NIP24_API char* nip24_krs_normalize(const char* krs)
-{
-	char num[MAX_NUMBER];
+/////////////////////////////////////////////////////////////////
 
+NIP24_API BOOL nip24_nip_normalize_into(const char* nip, char* out, size_t size)
+{
 	int len;
+	int p;
+	int i;
 
-	if (!krs || (len = (int)strlen(krs)) <= 0) {
-		return NULL;
+	if (!nip || !out || size < 11 || (len = (int)strlen(nip)) < 10 || len > 13) {
+		return FALSE;
 	}
 
 	// [0-9]{10}
-	snprintf(num, sizeof(num), "%010" PRIu64, atoll(krs));
+	for (i = 0, p = 0; i < len; i++) {
+		if (isdigit(nip[i])) {
+			if (p == 10) {
+				return FALSE;
+			}
 
-	if (strlen(num) != 10) {
-		return NULL;
+			out[p++] = nip[i];
+		}
 	}
 
-	return strdup(num);
+	if (p != 10) {
+		return FALSE;
+	}
+
+	out[p] = '\0';
+
+	return TRUE;
 }
 
-NIP24_API BOOL nip24_krs_is_valid(const char* krs)
+NIP24_API char* nip24_nip_normalize(const char* nip)
 {
-	char* num = nip24_krs_normalize(krs);
+	char num[MAX_NUMBER];
 
-	if (!num) {
-		return FALSE;
+	if (!nip24_nip_normalize_into(nip, num, sizeof(num))) {
+		return NULL;
 	}
 
-	free(num);
-
-	return TRUE;
+	return strdup(num);
 }
 
-NIP24_API char* nip24_euvat_normalize(const char* euvat)
+NIP24_API BOOL nip24_nip_is_valid(const char* nip)
 {
 	char num[MAX_NUMBER];
 
+	return nip24_number_check(NIP, nip, num, sizeof(num));
+}
+
+NIP24_API BOOL nip24_regon_normalize_into(const char* regon, char* out, size_t size)
+{
 	int len;
 	int p;
 	int i;
 
-	if (!euvat || (len = (int)strlen(euvat)) == 0) {
-		return NULL;
+	if (!regon || !out || size < 15 || (len = (int)strlen(regon)) < 9 || len > 14) {
+		return FALSE;
 	}
 
-	memset(num, 0, sizeof(num));
-
+	// [0-9]{9,14}
 	for (i = 0, p = 0; i < len; i++) {
-		if ((isalnum(euvat[i]) || euvat[i] == '+' || euvat[i] == '*') && p < (sizeof(num) - 1)) {
-			num[p++] = toupper(euvat[i]);
+		if (isdigit(regon[i])) {
+			out[p++] = regon[i];
 		}
 	}
 
-	if ((len = (int)strlen(num)) < 4 || len > 14) {
+	if (p != 9 && p != 14) {
+		return FALSE;
+	}
+
+	out[p] = '\0';
+
+	return TRUE;
+}
+
+NIP24_API char* nip24_regon_normalize(const char* regon)
+{
+	char num[MAX_NUMBER];
+
+	if (!nip24_regon_normalize_into(regon, num, sizeof(num))) {
 		return NULL;
 	}
 
 	return strdup(num);
 }
 
-NIP24_API BOOL nip24_euvat_is_valid(const char* euvat)
+NIP24_API BOOL nip24_regon_is_valid(const char* regon)
 {
-	BOOL ret = FALSE;
+	char num[MAX_NUMBER];
+
+	return nip24_number_check(REGON, regon, num, sizeof(num));
+}
 
-	char* num = nip24_euvat_normalize(euvat);
+NIP24_API BOOL nip24_krs_normalize_into(const char* krs, char* out, size_t size)
+{
+	char num[MAX_NUMBER];
 
 	int len;
+	int p;
+	int i;
 
-	if (!num) {
-		goto err;
+	if (!krs || !out || size < 11 || (len = (int)strlen(krs)) == 0) {
+		return FALSE;
 	}
 
-	len = (int)strlen(num);
-
-	if (strncmp(num, "AT", 2) == 0) {
-		// ATU\\d{8}
-		if (len != (3 + 8) || num[2] != 'U') {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 3, 8)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "BE", 2) == 0) {
-		// BE[0-1]{1}\d{9}
-		if (len != (3 + 9) || (num[2] != '0' && num[2] != '1')) {
-			goto err;
-		}
+	// [0-9]{10}, separatory pomijane, krotsze numery uzupelniane zerami z przodu
+	for (i = 0, p = 0; i < len; i++) {
+		if (isdigit(krs[i])) {
+			if (p == 10) {
+				return FALSE;
+			}
 
-		if (!_nip24_isdigit(num, 3, 9)) {
-			goto err;
+			num[p++] = krs[i];
 		}
 	}
-	else if (strncmp(num, "BG", 2) == 0) {
-		// BG\\d{9,10}
-		if (len < (2 + 9) || len > (2 + 10)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, len - 2)) {
-			goto err;
-		}
+	if (p == 0) {
+		return FALSE;
 	}
-	else if (strncmp(num, "CY", 2) == 0) {
-		// CY\d{8}[A-Z]{1}
-		if (len != (2 + 8 + 1) || !isalpha(num[len - 1])) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "CZ", 2) == 0) {
-		// CZ\\d{8,10}
-		if (len < (2 + 8) || len > (2 + 10)) {
-			goto err;
-		}
+	memset(out, '0', 10 - p);
+	memcpy(out + 10 - p, num, p);
 
-		if (!_nip24_isdigit(num, 2, len - 2)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "DE", 2) == 0) {
-		// DE\\d{9}
-		if (len != (2 + 9)) {
-			goto err;
-		}
+	out[10] = '\0';
 
-		if (!_nip24_isdigit(num, 2, 9)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "DK", 2) == 0) {
-		// DK\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
+	return TRUE;
+}
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "EE", 2) == 0) {
-		// EE\\d{9}
-		if (len != (2 + 9)) {
-			goto err;
-		}
+NIP24_API char* nip24_krs_normalize(const char* krs)
+{
+	char num[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 2, 9)) {
-			goto err;
-		}
+	if (!nip24_krs_normalize_into(krs, num, sizeof(num))) {
+		return NULL;
 	}
-	else if (strncmp(num, "EL", 2) == 0) {
-		// EL\\d{9}
-		if (len != (2 + 9)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 9)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "ES", 2) == 0) {
-		// ES[A-Z0-9]{1}\d{7}[A-Z0-9]{1}
-		if (len != (2 + 1 + 7 + 1)) {
-			goto err;
-		}
+	return strdup(num);
+}
 
-		if (!_nip24_isalnum(num, 2, 1)) {
-			goto err;
-		}
+NIP24_API BOOL nip24_krs_is_valid(const char* krs)
+{
+	char num[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 3, 7)) {
-			goto err;
-		}
+	return nip24_krs_normalize_into(krs, num, sizeof(num));
+}
 
-		if (!_nip24_isalnum(num, 10, 1)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "FI", 2) == 0) {
-		// FI\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
+NIP24_API BOOL nip24_euvat_normalize_into(const char* euvat, char* out, size_t size)
+{
+	int len;
+	int p;
+	int i;
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
+	if (!euvat || !out || size < 15 || (len = (int)strlen(euvat)) == 0) {
+		return FALSE;
 	}
-	else if (strncmp(num, "FR", 2) == 0) {
-		// FR[A-Z0-9]{2}\\d{9}
-		if (len != (2 + 2 + 9)) {
-			goto err;
-		}
 
-		if (!_nip24_isalnum(num, 2, 2)) {
-			goto err;
-		}
+	for (i = 0, p = 0; i < len; i++) {
+		if (isalnum(euvat[i]) || euvat[i] == '+' || euvat[i] == '*') {
+			if (p == 14) {
+				return FALSE;
+			}
 
-		if (!_nip24_isdigit(num, 4, 9)) {
-			goto err;
+			out[p++] = toupper(euvat[i]);
 		}
 	}
-	else if (strncmp(num, "HR", 2) == 0) {
-		// HR\\d{11}
-		if (len != (2 + 11)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 11)) {
-			goto err;
-		}
+	if (p < 4) {
+		return FALSE;
 	}
-	else if (strncmp(num, "HU", 2) == 0) {
-		// HU\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "IE", 2) == 0) {
-		// IE[A-Z0-9+*]{8,9}
-		if (len < (2 + 8) || len > (2 + 9)) {
-			goto err;
-		}
+	out[p] = '\0';
 
-		if (!_nip24_isalnum_ext(num, 2, len - 2)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "IT", 2) == 0) {
-		// IT\\d{11}
-		if (len != (2 + 11)) {
-			goto err;
-		}
+	return TRUE;
+}
 
-		if (!_nip24_isdigit(num, 2, 11)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LT", 2) == 0) {
-		// LT\\d{9,12}
-		if (len < (2 + 9) || len > (2 + 12)) {
-			goto err;
-		}
+NIP24_API char* nip24_euvat_normalize(const char* euvat)
+{
+	char num[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 2, len - 2)) {
-			goto err;
-		}
+	if (!nip24_euvat_normalize_into(euvat, num, sizeof(num))) {
+		return NULL;
 	}
-	else if (strncmp(num, "LU", 2) == 0) {
-		// LU\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LV", 2) == 0) {
-		// LV\\d{11}
-		if (len != (2 + 11)) {
-			goto err;
-		}
+	return strdup(num);
+}
 
-		if (!_nip24_isdigit(num, 2, 11)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "MT", 2) == 0) {
-		// MT\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
+static int _nip24_weighted(const char* num, const int* w, int count)
+{
+	int sum = 0;
+	int i;
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
-		}
+	for (i = 0; i < count; i++) {
+		sum += CHAR2NUM(num[i]) * w[i];
 	}
-	else if (strncmp(num, "NL", 2) == 0) {
-		// NL[A-Z0-9+*]{12}
-		if (len != (2 + 12)) {
-			goto err;
-		}
 
-		if (!_nip24_isalnum_ext(num, 2, 12)) {
-			goto err;
-		}
+	return sum;
+}
+
+static int _nip24_mod(const char* num, int count, int m)
+{
+	int r = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		r = (r * 10 + CHAR2NUM(num[i])) % m;
 	}
-	else if (strncmp(num, "PL", 2) == 0) {
-		// PL\\d{10}
-		if (len != (2 + 10)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 10)) {
-			goto err;
+	return r;
+}
+
+static BOOL _nip24_luhn(const char* num, int len)
+{
+	int sum = 0;
+	int d;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		d = CHAR2NUM(num[len - 1 - i]);
+
+		if (i % 2 == 1) {
+			d = (d * 2 > 9 ? d * 2 - 9 : d * 2);
 		}
+
+		sum += d;
 	}
-	else if (strncmp(num, "PT", 2) == 0) {
-		// PT\\d{9}
-		if (len != (2 + 9)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 9)) {
-			goto err;
-		}
+	return (sum % 10 == 0);
+}
+
+static int _nip24_mod11_10(const char* num, int count)
+{
+	int p = 10;
+	int s;
+	int i;
+
+	// ISO 7064 MOD 11,10
+	for (i = 0; i < count; i++) {
+		s = (CHAR2NUM(num[i]) + p) % 10;
+		p = ((s == 0 ? 10 : s) * 2) % 11;
 	}
-	else if (strncmp(num, "RO", 2) == 0) {
-		// RO\\d{2,10}
-		if (len < (2 + 2) || len > (2 + 10)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, len - 2)) {
-			goto err;
-		}
+	return (11 - p) % 10;
+}
+
+static BOOL _nip24_euvat_at(const char* num, int len)
+{
+	int sum = 0;
+	int p;
+	int i;
+
+	// U + 8 cyfr
+	for (i = 0; i < 7; i++) {
+		p = CHAR2NUM(num[1 + i]) * (i % 2 + 1);
+		sum += p / 10 + p % 10;
 	}
-	else if (strncmp(num, "SE", 2) == 0) {
-		// SE\\d{12}
-		if (len != (2 + 12)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 12)) {
-			goto err;
+	return ((10 - (sum + 4) % 10) % 10 == CHAR2NUM(num[8]));
+}
+
+static BOOL _nip24_euvat_be(const char* num, int len)
+{
+	return (97 - _nip24_mod(num, 8, 97) == CHAR2NUM(num[8]) * 10 + CHAR2NUM(num[9]));
+}
+
+static BOOL _nip24_euvat_bg(const char* num, int len)
+{
+	int w1[] = {
+		1, 2, 3, 4, 5, 6, 7, 8
+	};
+
+	int w3[] = {
+		3, 4, 5, 6, 7, 8, 9, 10
+	};
+
+	int wp[] = {
+		2, 4, 8, 5, 10, 9, 7, 3, 6
+	};
+
+	int wf[] = {
+		21, 19, 17, 13, 11, 9, 7, 3, 1
+	};
+
+	int wo[] = {
+		4, 3, 2, 7, 6, 5, 4, 3, 2
+	};
+
+	int r;
+
+	if (len == 9) {
+		if ((r = _nip24_weighted(num, w1, 8) % 11) == 10) {
+			r = _nip24_weighted(num, w3, 8) % 11 % 10;
 		}
+
+		return (r == CHAR2NUM(num[8]));
+	}
+
+	// 10 cyfr: osoba fizyczna (EGN), cudzoziemiec lub inny podmiot
+	if (_nip24_weighted(num, wp, 9) % 11 % 10 == CHAR2NUM(num[9])) {
+		return TRUE;
+	}
+
+	if (_nip24_weighted(num, wf, 9) % 10 == CHAR2NUM(num[9])) {
+		return TRUE;
+	}
+
+	r = (11 - _nip24_weighted(num, wo, 9) % 11) % 11;
+
+	return (r != 10 && r == CHAR2NUM(num[9]));
+}
+
+static BOOL _nip24_euvat_cy(const char* num, int len)
+{
+	int odd[] = {
+		1, 0, 5, 7, 9, 13, 15, 17, 19, 21
+	};
+
+	int sum = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		sum += (i % 2 == 0 ? odd[CHAR2NUM(num[i])] : CHAR2NUM(num[i]));
+	}
+
+	return (num[8] == 'A' + sum % 26);
+}
+
+static BOOL _nip24_euvat_cz(const char* num, int len)
+{
+	int w[] = {
+		8, 7, 6, 5, 4, 3, 2
+	};
+
+	int r;
+
+	if (len == 8) {
+		return ((11 - _nip24_weighted(num, w, 7) % 11) % 10 == CHAR2NUM(num[7]));
 	}
-	else if (strncmp(num, "SI", 2) == 0) {
-		// SI\\d{8}
-		if (len != (2 + 8)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 8)) {
-			goto err;
+	if (len == 9) {
+		// osoby fizyczne bez rodnego cisla (6xxxxxxxx), pozostale numery 9-cyfrowe nie maja
+		// cyfry kontrolnej
+		if (num[0] != '6') {
+			return TRUE;
 		}
+
+		r = _nip24_weighted(num + 1, w, 7) % 11;
+
+		return ((18 - (10 - r) % 11) % 10 == CHAR2NUM(num[8]));
 	}
-	else if (strncmp(num, "SK", 2) == 0) {
-		// SK\\d{10}
-		if (len != (2 + 10)) {
-			goto err;
+
+	// rodne cislo
+	r = _nip24_mod(num, 9, 11);
+
+	return ((r * 10 + CHAR2NUM(num[9])) % 11 == 0 || (r == 10 && num[9] == '0'));
+}
+
+static BOOL _nip24_euvat_de(const char* num, int len)
+{
+	return (_nip24_mod11_10(num, 8) == CHAR2NUM(num[8]));
+}
+
+static BOOL _nip24_euvat_dk(const char* num, int len)
+{
+	int w[] = {
+		2, 7, 6, 5, 4, 3, 2, 1
+	};
+
+	return (_nip24_weighted(num, w, 8) % 11 == 0);
+}
+
+static BOOL _nip24_euvat_ee(const char* num, int len)
+{
+	int w[] = {
+		3, 7, 1, 3, 7, 1, 3, 7
+	};
+
+	return ((10 - _nip24_weighted(num, w, 8) % 10) % 10 == CHAR2NUM(num[8]));
+}
+
+static BOOL _nip24_euvat_el(const char* num, int len)
+{
+	int w[] = {
+		256, 128, 64, 32, 16, 8, 4, 2
+	};
+
+	return (_nip24_weighted(num, w, 8) % 11 % 10 == CHAR2NUM(num[8]));
+}
+
+static BOOL _nip24_euvat_es(const char* num, int len)
+{
+	int sum = 0;
+	int n;
+	int p;
+	int i;
+
+	if (isdigit(num[0]) || strchr("KLMXYZ", num[0])) {
+		// DNI lub NIE: litera kontrolna z numeru 8-cyfrowego (X = 0, Y = 1, Z = 2)
+		n = (isdigit(num[0]) ? CHAR2NUM(num[0]) : num[0] == 'Y' ? 1 : num[0] == 'Z' ? 2 : 0);
+
+		for (i = 1; i < 8; i++) {
+			if (!isdigit(num[i])) {
+				return FALSE;
+			}
+
+			n = n * 10 + CHAR2NUM(num[i]);
 		}
 
-		if (!_nip24_isdigit(num, 2, 10)) {
-			goto err;
+		return (num[8] == "TRWAGMYFPDXBNJZSQVHLCKE"[n % 23]);
+	}
+
+	// CIF: cyfra lub litera kontrolna
+	for (i = 0; i < 7; i++) {
+		p = CHAR2NUM(num[1 + i]) * (i % 2 == 0 ? 2 : 1);
+		sum += p / 10 + p % 10;
+	}
+
+	n = (10 - sum % 10) % 10;
+
+	return (num[8] == '0' + n || num[8] == "JABCDEFGHI"[n]);
+}
+
+static BOOL _nip24_euvat_fi(const char* num, int len)
+{
+	int w[] = {
+		7, 9, 10, 5, 8, 4, 2
+	};
+
+	int r = _nip24_weighted(num, w, 7) % 11;
+
+	return (r != 1 && (11 - r) % 11 == CHAR2NUM(num[7]));
+}
+
+static BOOL _nip24_euvat_fr(const char* num, int len)
+{
+	// klucze literowe nie maja jednoznacznego algorytmu
+	if (!isdigit(num[0]) || !isdigit(num[1])) {
+		return TRUE;
+	}
+
+	return ((12 + 3 * _nip24_mod(num + 2, 9, 97)) % 97 == CHAR2NUM(num[0]) * 10 + CHAR2NUM(num[1]));
+}
+
+static BOOL _nip24_euvat_hr(const char* num, int len)
+{
+	return (_nip24_mod11_10(num, 10) == CHAR2NUM(num[10]));
+}
+
+static BOOL _nip24_euvat_hu(const char* num, int len)
+{
+	int w[] = {
+		9, 7, 3, 1, 9, 7, 3
+	};
+
+	return ((10 - _nip24_weighted(num, w, 7) % 10) % 10 == CHAR2NUM(num[7]));
+}
+
+static BOOL _nip24_euvat_ie(const char* num, int len)
+{
+	const char* letters = "WABCDEFGHIJKLMNOPQRSTUV";
+
+	int w[] = {
+		8, 7, 6, 5, 4, 3, 2
+	};
+
+	char digits[7];
+	const char* s;
+	int sum;
+
+	if (_nip24_isdigit((char*)num, 0, 7)) {
+		// 7 cyfr, litera kontrolna i opcjonalna litera dodatkowa
+		memcpy(digits, num, 7);
+
+		sum = _nip24_weighted(digits, w, 7);
+
+		if (len == 9) {
+			if (!(s = strchr(letters, num[8]))) {
+				return FALSE;
+			}
+
+			sum += 9 * (int)(s - letters);
 		}
 	}
-	else if (strncmp(num, "XI", 2) == 0) {
-		// XI[A-Z0-9]{5,12}
-		if (len < (2 + 5) || len > (2 + 12)) {
-			goto err;
+	else if (len == 8 && isdigit(num[0]) && _nip24_isdigit((char*)num, 2, 5)) {
+		// stary format: cyfra, znak, 5 cyfr, litera kontrolna
+		digits[0] = '0';
+		memcpy(digits + 1, num + 2, 5);
+		digits[6] = num[0];
+
+		sum = _nip24_weighted(digits, w, 7);
+	}
+	else {
+		return FALSE;
+	}
+
+	return (num[7] == letters[sum % 23]);
+}
+
+static BOOL _nip24_euvat_it(const char* num, int len)
+{
+	return _nip24_luhn(num, 11);
+}
+
+static BOOL _nip24_euvat_lt(const char* num, int len)
+{
+	int sum = 0;
+	int r;
+	int i;
+
+	// 9 cyfr (osoby prawne) lub 12 cyfr (pozostali), przedostatnia cyfra to 1
+	if ((len != 9 && len != 12) || num[len - 2] != '1') {
+		return FALSE;
+	}
+
+	for (i = 0; i < len - 1; i++) {
+		sum += (1 + i % 9) * CHAR2NUM(num[i]);
+	}
+
+	if ((r = sum % 11) == 10) {
+		for (i = 0, sum = 0; i < len - 1; i++) {
+			sum += (1 + (i + 2) % 9) * CHAR2NUM(num[i]);
 		}
 
-		if (!_nip24_isalnum(num, 2, len - 2)) {
-			goto err;
+		r = sum % 11 % 10;
+	}
+
+	return (r == CHAR2NUM(num[len - 1]));
+}
+
+static BOOL _nip24_euvat_lu(const char* num, int len)
+{
+	return (_nip24_mod(num, 6, 89) == CHAR2NUM(num[6]) * 10 + CHAR2NUM(num[7]));
+}
+
+static BOOL _nip24_euvat_lv(const char* num, int len)
+{
+	int w[] = {
+		9, 1, 4, 8, 3, 10, 2, 5, 7, 6, 1
+	};
+
+	// osoby fizyczne nie maja potwierdzonego algorytmu
+	if (num[0] <= '3') {
+		return TRUE;
+	}
+
+	return (_nip24_weighted(num, w, 11) % 11 == 3);
+}
+
+static BOOL _nip24_euvat_mt(const char* num, int len)
+{
+	int w[] = {
+		3, 4, 6, 7, 8, 9, 10, 1
+	};
+
+	return (_nip24_weighted(num, w, 8) % 37 == 0);
+}
+
+static BOOL _nip24_euvat_nl(const char* num, int len)
+{
+	int w[] = {
+		9, 8, 7, 6, 5, 4, 3, 2
+	};
+
+	int r;
+	int i;
+
+	// 9 cyfr, B, 2 cyfry
+	if (num[9] != 'B' || !_nip24_isdigit((char*)num, 0, 9) || !_nip24_isdigit((char*)num, 10, 2)) {
+		return FALSE;
+	}
+
+	if (_nip24_weighted(num, w, 8) % 11 == CHAR2NUM(num[8])) {
+		return TRUE;
+	}
+
+	// jednoosobowe dzialalnosci: ISO 7064 MOD 97-10 numeru z prefiksem NL (N = 23, L = 21, B = 11)
+	for (i = 0, r = 2321 % 97; i < 12; i++) {
+		r = (num[i] == 'B' ? r * 100 + 11 : r * 10 + CHAR2NUM(num[i])) % 97;
+	}
+
+	return (r == 1);
+}
+
+static BOOL _nip24_euvat_pl(const char* num, int len)
+{
+	return _nip24_nip_is_valid(num);
+}
+
+static BOOL _nip24_euvat_pt(const char* num, int len)
+{
+	int w[] = {
+		9, 8, 7, 6, 5, 4, 3, 2
+	};
+
+	int r = 11 - _nip24_weighted(num, w, 8) % 11;
+
+	return ((r >= 10 ? 0 : r) == CHAR2NUM(num[8]));
+}
+
+static BOOL _nip24_euvat_ro(const char* num, int len)
+{
+	int w[] = {
+		7, 5, 3, 2, 1, 7, 5, 3, 2
+	};
+
+	// wagi wyrownane do prawej strony
+	return (_nip24_weighted(num, w + 10 - len, len - 1) * 10 % 11 % 10 == CHAR2NUM(num[len - 1]));
+}
+
+static BOOL _nip24_euvat_se(const char* num, int len)
+{
+	return (_nip24_luhn(num, 10) && num[10] == '0' && num[11] == '1');
+}
+
+static BOOL _nip24_euvat_si(const char* num, int len)
+{
+	int w[] = {
+		8, 7, 6, 5, 4, 3, 2
+	};
+
+	int r = 11 - _nip24_weighted(num, w, 7) % 11;
+
+	return (r != 11 && r % 10 == CHAR2NUM(num[7]));
+}
+
+static BOOL _nip24_euvat_sk(const char* num, int len)
+{
+	return (_nip24_mod(num, 10, 11) == 0);
+}
+
+static BOOL _nip24_euvat_xi(const char* num, int len)
+{
+	int w[] = {
+		8, 7, 6, 5, 4, 3, 2
+	};
+
+	int sum;
+
+	// departamenty rzadowe (GD) i sluzba zdrowia (HA) nie maja cyfry kontrolnej
+	if ((len != 9 && len != 12) || !_nip24_isdigit((char*)num, 0, len)) {
+		return TRUE;
+	}
+
+	sum = _nip24_weighted(num, w, 7) + CHAR2NUM(num[7]) * 10 + CHAR2NUM(num[8]);
+
+	return (sum % 97 == 0 || (sum + 55) % 97 == 0);
+}
+
+static const EUVATFormat _nip24_euvat_formats[26 * 26] = {
+	[COUNTRY2IDX('A', 'T')] = { 11, 11, "U", { { 'n', 8 } }, FALSE, _nip24_euvat_at },
+	[COUNTRY2IDX('B', 'E')] = { 12, 12, "01", { { 'n', 9 } }, FALSE, _nip24_euvat_be },
+	[COUNTRY2IDX('B', 'G')] = { 11, 12, NULL, { { 'n', RUN_VAR } }, TRUE, _nip24_euvat_bg },
+	[COUNTRY2IDX('C', 'Y')] = { 11, 11, NULL, { { 'n', 8 }, { 'a', 1 } }, FALSE, _nip24_euvat_cy },
+	[COUNTRY2IDX('C', 'Z')] = { 10, 12, NULL, { { 'n', RUN_VAR } }, TRUE, _nip24_euvat_cz },
+	[COUNTRY2IDX('D', 'E')] = { 11, 11, NULL, { { 'n', 9 } }, FALSE, _nip24_euvat_de },
+	[COUNTRY2IDX('D', 'K')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_dk },
+	[COUNTRY2IDX('E', 'E')] = { 11, 11, NULL, { { 'n', 9 } }, FALSE, _nip24_euvat_ee },
+	[COUNTRY2IDX('E', 'L')] = { 11, 11, NULL, { { 'n', 9 } }, FALSE, _nip24_euvat_el },
+	[COUNTRY2IDX('E', 'S')] = { 11, 11, NULL, { { 'c', 1 }, { 'n', 7 }, { 'c', 1 } }, FALSE, _nip24_euvat_es },
+	[COUNTRY2IDX('F', 'I')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_fi },
+	[COUNTRY2IDX('F', 'R')] = { 13, 13, NULL, { { 'c', 2 }, { 'n', 9 } }, TRUE, _nip24_euvat_fr },
+	[COUNTRY2IDX('H', 'R')] = { 13, 13, NULL, { { 'n', 11 } }, FALSE, _nip24_euvat_hr },
+	[COUNTRY2IDX('H', 'U')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_hu },
+	[COUNTRY2IDX('I', 'E')] = { 10, 11, NULL, { { 'x', RUN_VAR } }, FALSE, _nip24_euvat_ie },
+	[COUNTRY2IDX('I', 'T')] = { 13, 13, NULL, { { 'n', 11 } }, FALSE, _nip24_euvat_it },
+	[COUNTRY2IDX('L', 'T')] = { 11, 14, NULL, { { 'n', RUN_VAR } }, FALSE, _nip24_euvat_lt },
+	[COUNTRY2IDX('L', 'U')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_lu },
+	[COUNTRY2IDX('L', 'V')] = { 13, 13, NULL, { { 'n', 11 } }, TRUE, _nip24_euvat_lv },
+	[COUNTRY2IDX('M', 'T')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_mt },
+	[COUNTRY2IDX('N', 'L')] = { 14, 14, NULL, { { 'x', 12 } }, FALSE, _nip24_euvat_nl },
+	[COUNTRY2IDX('P', 'L')] = { 12, 12, NULL, { { 'n', 10 } }, FALSE, _nip24_euvat_pl },
+	[COUNTRY2IDX('P', 'T')] = { 11, 11, NULL, { { 'n', 9 } }, FALSE, _nip24_euvat_pt },
+	[COUNTRY2IDX('R', 'O')] = { 4, 12, NULL, { { 'n', RUN_VAR } }, FALSE, _nip24_euvat_ro },
+	[COUNTRY2IDX('S', 'E')] = { 14, 14, NULL, { { 'n', 12 } }, FALSE, _nip24_euvat_se },
+	[COUNTRY2IDX('S', 'I')] = { 10, 10, NULL, { { 'n', 8 } }, FALSE, _nip24_euvat_si },
+	[COUNTRY2IDX('S', 'K')] = { 12, 12, NULL, { { 'n', 10 } }, FALSE, _nip24_euvat_sk },
+	[COUNTRY2IDX('X', 'I')] = { 7, 14, NULL, { { 'c', RUN_VAR } }, TRUE, _nip24_euvat_xi },
+};
+
+static BOOL _nip24_euvat_is_valid(char* num, int flags)
+{
+	const EUVATFormat* f;
+
+	int fixed;
+	int len;
+	int i;
+
+	len = (int)strlen(num);
+
+	if (!isupper(num[0]) || !isupper(num[1])) {
+		return FALSE;
+	}
+
+	f = &_nip24_euvat_formats[COUNTRY2IDX(num[0], num[1])];
+
+	if (f->min == 0 || len < f->min || len > f->max) {
+		return FALSE;
+	}
+
+	if (f->prefix && !strchr(f->prefix, num[2])) {
+		return FALSE;
+	}
+
+	// dlugosc ciagu o zmiennej dlugosci
+	fixed = 2 + (f->prefix ? 1 : 0);
+
+	for (i = 0; i < RUNS_MAX && f->run[i].count > 0; i++) {
+		if (f->run[i].count != RUN_VAR) {
+			fixed += f->run[i].count;
 		}
 	}
-	else {
-		goto err;
+
+	if (!_nip24_check_runs(num, 2 + (f->prefix ? 1 : 0), f->run, RUNS_MAX, len - fixed)) {
+		return FALSE;
 	}
 
-	if (strncmp(num, "PL", 2) == 0 && !nip24_nip_is_valid(num + 2)) {
-		goto err;
+	if (flags & NIP24_VALIDATE_NO_CHECKSUM) {
+		return TRUE;
 	}
 
-	ret = TRUE;
+	if (f->ambiguous && (flags & NIP24_VALIDATE_NO_AMBIGUOUS)) {
+		return TRUE;
+	}
+
+	return f->checksum(num + 2, len - 2);
+}
 
-err:
-	free(num);
+NIP24_API BOOL nip24_euvat_is_valid(const char* euvat)
+{
+	char num[MAX_NUMBER];
 
-	return ret;
+	return nip24_number_check(EUVAT, euvat, num, sizeof(num));
 }
 
-NIP24_API char* nip24_iban_normalize(const char* iban)
+NIP24_API BOOL nip24_euvat_is_valid_ex(const char* euvat, int flags)
 {
 	char num[MAX_NUMBER];
 
+	return (nip24_euvat_normalize_into(euvat, num, sizeof(num)) && _nip24_euvat_is_valid(num, flags));
+}
+
+NIP24_API BOOL nip24_iban_normalize_into(const char* iban, char* out, size_t size)
+{
 	int len;
 	int p;
 	int i;
 
-	if (!iban || (len = (int)strlen(iban)) == 0) {
-		return NULL;
+	if (!iban || !out || size < 33 || (len = (int)strlen(iban)) == 0) {
+		return FALSE;
 	}
 
-	memset(num, 0, sizeof(num));
-
 	for (i = 0, p = 0; i < len; i++) {
-		if (isalnum(iban[i]) && p < (sizeof(num) - 1)) {
-			num[p++] = toupper(iban[i]);
+		if (isalnum(iban[i])) {
+			if (p == 32) {
+				return FALSE;
+			}
+
+			out[p++] = toupper(iban[i]);
 		}
 	}
 
-	if ((len = (int)strlen(num)) < 15 || len > 32) {
+	if (p < 15) {
+		return FALSE;
+	}
+
+	out[p] = '\0';
+
+	return TRUE;
+}
+
+NIP24_API char* nip24_iban_normalize(const char* iban)
+{
+	char num[MAX_NUMBER];
+
+	if (!nip24_iban_normalize_into(iban, num, sizeof(num))) {
 		return NULL;
 	}
 
 	return strdup(num);
 }
 
-NIP24_API BOOL nip24_iban_is_valid(const char* iban)
+static int _nip24_mod97(const char* num, int count)
+{
+	int r = 0;
+	int i;
+
+	// litery jako liczby 10-35
+	for (i = 0; i < count; i++) {
+		r = (isalpha(num[i]) ? r * 100 + (num[i] - 55) : r * 10 + CHAR2NUM(num[i])) % 97;
+	}
+
+	return r;
+}
+
+static BOOL _nip24_bban_mod97(const char* bban, int len)
+{
+	// krajowe cyfry kontrolne ISO 7064 MOD 97-10 na koncu BBAN
+	return (_nip24_mod97(bban, len) == 1);
+}
+
+static BOOL _nip24_bban_be(const char* bban, int len)
+{
+	int r = _nip24_mod(bban, 10, 97);
+
+	return ((r == 0 ? 97 : r) == CHAR2NUM(bban[10]) * 10 + CHAR2NUM(bban[11]));
+}
+
+static BOOL _nip24_bban_ee(const char* bban, int len)
+{
+	int w[] = {
+		7, 3, 1
+	};
+
+	int sum = 0;
+	int i;
+
+	// numer rachunku (bez kodu banku), wagi 7, 3, 1 od prawej strony
+	for (i = len - 2; i >= 2; i--) {
+		sum += CHAR2NUM(bban[i]) * w[(len - 2 - i) % 3];
+	}
+
+	return ((10 - sum % 10) % 10 == CHAR2NUM(bban[len - 1]));
+}
+
+static BOOL _nip24_bban_es(const char* bban, int len)
+{
+	int w[] = {
+		1, 2, 4, 8, 5, 10, 9, 7, 3, 6
+	};
+
+	int r;
+
+	// DC: pierwsza cyfra z kodu banku i oddzialu (wagi od 3 pozycji), druga z numeru rachunku
+	r = 11 - _nip24_weighted(bban, w + 2, 8) % 11;
+
+	if ((r == 11 ? 0 : r == 10 ? 1 : r) != CHAR2NUM(bban[8])) {
+		return FALSE;
+	}
+
+	r = 11 - _nip24_weighted(bban + 10, w, 10) % 11;
+
+	return ((r == 11 ? 0 : r == 10 ? 1 : r) == CHAR2NUM(bban[9]));
+}
+
+static BOOL _nip24_bban_fi(const char* bban, int len)
+{
+	return _nip24_luhn(bban, len);
+}
+
+static BOOL _nip24_bban_fr(const char* bban, int len)
+{
+	int r = 0;
+	int d;
+	int i;
+
+	// klucz RIB: bank, oddzial, rachunek i klucz podzielne przez 97, litery rachunku
+	// zamieniane na cyfry (A, J = 1; B, K, S = 2; ...)
+	for (i = 0; i < len; i++) {
+		if (isalpha(bban[i])) {
+			d = (bban[i] - 'A' + (bban[i] >= 'S' ? 2 : 1)) % 9;
+			d = (d == 0 ? 9 : d);
+		}
+		else {
+			d = CHAR2NUM(bban[i]);
+		}
+
+		r = (r * 10 + d) % 97;
+	}
+
+	return (r == 0);
+}
+
+static BOOL _nip24_bban_it(const char* bban, int len)
+{
+	int odd[] = {
+		1, 0, 5, 7, 9, 13, 15, 17, 19, 21, 2, 4, 18, 20, 11, 3, 6, 8, 12, 14, 16, 10, 22, 25, 24, 23
+	};
+
+	int sum = 0;
+	int v;
+	int i;
+
+	// CIN: litera kontrolna z ABI, CAB i numeru rachunku
+	for (i = 1; i < len; i++) {
+		v = (isdigit(bban[i]) ? CHAR2NUM(bban[i]) : bban[i] - 'A');
+		sum += ((i - 1) % 2 == 0 ? odd[v] : v);
+	}
+
+	return (bban[0] == 'A' + sum % 26);
+}
+
+static BOOL _nip24_bban_no(const char* bban, int len)
+{
+	int w[] = {
+		5, 4, 3, 2, 7, 6, 5, 4, 3, 2
+	};
+
+	int r = 11 - _nip24_weighted(bban, w, 10) % 11;
+
+	return (r != 10 && r % 11 == CHAR2NUM(bban[10]));
+}
+
+static BOOL _nip24_bban_pl(const char* bban, int len)
+{
+	int w[] = {
+		3, 9, 7, 1, 3, 9, 7
+	};
+
+	// cyfra kontrolna numeru rozliczeniowego banku
+	return ((10 - _nip24_weighted(bban, w, 7) % 10) % 10 == CHAR2NUM(bban[7]));
+}
+
+static const IBANFormat _nip24_iban_formats[26 * 26] = {
+	[COUNTRY2IDX('A', 'D')] = { 24, { { 'n', 10 }, { 'c', 12 } } },
+	[COUNTRY2IDX('A', 'E')] = { 23, { { 'n', 21 } } },
+	[COUNTRY2IDX('A', 'L')] = { 28, { { 'n', 10 }, { 'c', 16 } } },
+	[COUNTRY2IDX('A', 'T')] = { 20, { { 'n', 18 } } },
+	[COUNTRY2IDX('A', 'Z')] = { 28, { { 'n', 2 }, { 'a', 4 }, { 'c', 20 } } },
+	[COUNTRY2IDX('B', 'A')] = { 20, { { 'n', 18 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('B', 'E')] = { 16, { { 'n', 14 } }, _nip24_bban_be },
+	[COUNTRY2IDX('B', 'G')] = { 22, { { 'n', 2 }, { 'a', 4 }, { 'n', 6 }, { 'c', 8 } } },
+	[COUNTRY2IDX('B', 'H')] = { 22, { { 'n', 2 }, { 'a', 4 }, { 'c', 14 } } },
+	[COUNTRY2IDX('B', 'R')] = { 29, { { 'n', 25 }, { 'a', 1 }, { 'c', 1 } } },
+	[COUNTRY2IDX('B', 'Y')] = { 28, { { 'n', 2 }, { 'c', 4 }, { 'n', 4 }, { 'c', 16 } } },
+	[COUNTRY2IDX('C', 'H')] = { 21, { { 'n', 7 }, { 'c', 12 } } },
+	[COUNTRY2IDX('C', 'R')] = { 22, { { 'n', 20 } } },
+	[COUNTRY2IDX('C', 'Y')] = { 28, { { 'n', 10 }, { 'c', 16 } } },
+	[COUNTRY2IDX('C', 'Z')] = { 24, { { 'n', 22 } } },
+	[COUNTRY2IDX('D', 'E')] = { 22, { { 'n', 20 } } },
+	[COUNTRY2IDX('D', 'K')] = { 18, { { 'n', 16 } } },
+	[COUNTRY2IDX('D', 'O')] = { 28, { { 'n', 2 }, { 'c', 4 }, { 'n', 20 } } },
+	[COUNTRY2IDX('E', 'E')] = { 20, { { 'n', 18 } }, _nip24_bban_ee },
+	[COUNTRY2IDX('E', 'S')] = { 24, { { 'n', 22 } }, _nip24_bban_es },
+	[COUNTRY2IDX('F', 'I')] = { 18, { { 'n', 16 } }, _nip24_bban_fi },
+	[COUNTRY2IDX('F', 'O')] = { 18, { { 'n', 16 } } },
+	[COUNTRY2IDX('F', 'R')] = { 27, { { 'n', 12 }, { 'c', 11 }, { 'n', 2 } }, _nip24_bban_fr },
+	[COUNTRY2IDX('G', 'B')] = { 22, { { 'n', 2 }, { 'a', 4 }, { 'n', 14 } } },
+	[COUNTRY2IDX('G', 'E')] = { 22, { { 'n', 2 }, { 'a', 2 }, { 'n', 16 } } },
+	[COUNTRY2IDX('G', 'I')] = { 23, { { 'n', 2 }, { 'a', 4 }, { 'c', 15 } } },
+	[COUNTRY2IDX('G', 'L')] = { 18, { { 'n', 16 } } },
+	[COUNTRY2IDX('G', 'R')] = { 27, { { 'n', 9 }, { 'c', 16 } } },
+	[COUNTRY2IDX('G', 'T')] = { 28, { { 'n', 2 }, { 'c', 24 } } },
+	[COUNTRY2IDX('H', 'R')] = { 21, { { 'n', 19 } } },
+	[COUNTRY2IDX('H', 'U')] = { 28, { { 'n', 26 } } },
+	[COUNTRY2IDX('I', 'E')] = { 22, { { 'n', 2 }, { 'a', 4 }, { 'n', 14 } } },
+	[COUNTRY2IDX('I', 'L')] = { 23, { { 'n', 21 } } },
+	[COUNTRY2IDX('I', 'Q')] = { 23, { { 'n', 2 }, { 'a', 4 }, { 'n', 15 } } },
+	[COUNTRY2IDX('I', 'S')] = { 26, { { 'n', 24 } } },
+	[COUNTRY2IDX('I', 'T')] = { 27, { { 'n', 2 }, { 'a', 1 }, { 'n', 10 }, { 'c', 12 } }, _nip24_bban_it },
+	[COUNTRY2IDX('J', 'O')] = { 30, { { 'n', 2 }, { 'a', 4 }, { 'n', 4 }, { 'c', 18 } } },
+	[COUNTRY2IDX('K', 'W')] = { 30, { { 'n', 2 }, { 'a', 4 }, { 'c', 22 } } },
+	[COUNTRY2IDX('K', 'Z')] = { 20, { { 'n', 5 }, { 'c', 13 } } },
+	[COUNTRY2IDX('L', 'B')] = { 28, { { 'n', 6 }, { 'c', 20 } } },
+	[COUNTRY2IDX('L', 'C')] = { 32, { { 'n', 2 }, { 'a', 4 }, { 'c', 24 } } },
+	[COUNTRY2IDX('L', 'I')] = { 21, { { 'n', 7 }, { 'c', 12 } } },
+	[COUNTRY2IDX('L', 'T')] = { 20, { { 'n', 18 } } },
+	[COUNTRY2IDX('L', 'U')] = { 20, { { 'n', 5 }, { 'c', 13 } } },
+	[COUNTRY2IDX('L', 'V')] = { 21, { { 'n', 2 }, { 'a', 4 }, { 'c', 13 } } },
+	[COUNTRY2IDX('M', 'C')] = { 27, { { 'n', 12 }, { 'c', 11 }, { 'n', 2 } }, _nip24_bban_fr },
+	[COUNTRY2IDX('M', 'D')] = { 24, { { 'n', 2 }, { 'c', 20 } } },
+	[COUNTRY2IDX('M', 'E')] = { 22, { { 'n', 20 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('M', 'K')] = { 19, { { 'n', 5 }, { 'c', 10 }, { 'n', 2 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('M', 'R')] = { 27, { { 'n', 25 } } },
+	[COUNTRY2IDX('M', 'T')] = { 31, { { 'n', 2 }, { 'a', 4 }, { 'n', 5 }, { 'c', 18 } } },
+	[COUNTRY2IDX('M', 'U')] = { 30, { { 'n', 2 }, { 'a', 4 }, { 'n', 19 }, { 'a', 3 } } },
+	[COUNTRY2IDX('N', 'L')] = { 18, { { 'n', 2 }, { 'a', 4 }, { 'n', 10 } } },
+	[COUNTRY2IDX('N', 'O')] = { 15, { { 'n', 13 } }, _nip24_bban_no },
+	[COUNTRY2IDX('P', 'K')] = { 24, { { 'n', 2 }, { 'a', 4 }, { 'c', 16 } } },
+	[COUNTRY2IDX('P', 'L')] = { 28, { { 'n', 26 } }, _nip24_bban_pl },
+	[COUNTRY2IDX('P', 'S')] = { 29, { { 'n', 2 }, { 'a', 4 }, { 'c', 21 } } },
+	[COUNTRY2IDX('P', 'T')] = { 25, { { 'n', 23 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('Q', 'A')] = { 29, { { 'n', 2 }, { 'a', 4 }, { 'c', 21 } } },
+	[COUNTRY2IDX('R', 'O')] = { 24, { { 'n', 2 }, { 'a', 4 }, { 'c', 16 } } },
+	[COUNTRY2IDX('R', 'S')] = { 22, { { 'n', 20 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('S', 'A')] = { 24, { { 'n', 4 }, { 'c', 18 } } },
+	[COUNTRY2IDX('S', 'C')] = { 31, { { 'n', 2 }, { 'a', 4 }, { 'n', 20 }, { 'a', 3 } } },
+	[COUNTRY2IDX('S', 'E')] = { 24, { { 'n', 22 } } },
+	[COUNTRY2IDX('S', 'I')] = { 19, { { 'n', 17 } }, _nip24_bban_mod97 },
+	[COUNTRY2IDX('S', 'K')] = { 24, { { 'n', 22 } } },
+	[COUNTRY2IDX('S', 'M')] = { 27, { { 'n', 2 }, { 'a', 1 }, { 'n', 10 }, { 'c', 12 } }, _nip24_bban_it },
+	[COUNTRY2IDX('S', 'T')] = { 25, { { 'n', 23 } } },
+	[COUNTRY2IDX('S', 'V')] = { 28, { { 'n', 2 }, { 'a', 4 }, { 'n', 20 } } },
+	[COUNTRY2IDX('T', 'L')] = { 23, { { 'n', 21 } } },
+	[COUNTRY2IDX('T', 'N')] = { 24, { { 'n', 22 } } },
+	[COUNTRY2IDX('T', 'R')] = { 26, { { 'n', 8 }, { 'c', 16 } } },
+	[COUNTRY2IDX('U', 'A')] = { 29, { { 'n', 8 }, { 'c', 19 } } },
+	[COUNTRY2IDX('V', 'G')] = { 24, { { 'n', 2 }, { 'a', 4 }, { 'n', 16 } } },
+	[COUNTRY2IDX('X', 'K')] = { 20, { { 'n', 18 } } },
+};
+
+const FormatRun* iban_format(const char* num, int* length)
+{
+	const IBANFormat* f;
+
+	if (!isupper(num[0]) || !isupper(num[1])) {
+		return NULL;
+	}
+
+	f = &_nip24_iban_formats[COUNTRY2IDX(num[0], num[1])];
+
+	if (f->length == 0) {
+		return NULL;
+	}
+
+	*length = f->length;
+
+	return f->run;
+}
+
+static BOOL _nip24_iban_is_valid(char* num, int flags)
 {
-	BOOL ret = FALSE;
-
-	char* num = nip24_iban_normalize(iban);
+	const IBANFormat* f;
 
-	char str[MAX_NUMBER * 2];
-	char sb[MAX_NUMBER];
+	uint64_t chk = 0;
 
-	int chk;
+	int digits = 0;
 	int len;
 	int i;
-	int p;
-
-	if (!num) {
-		goto err;
-	}
+	char c;
 
 	len = (int)strlen(num);
 
-	if (strncmp(num, "AD", 2) == 0) {
-		// AD\\d{10}[A-Z0-9]{12}
-		if (len != (2 + 10 + 12)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 10) || !_nip24_isalnum(num, 12, 12)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "AE", 2) == 0) {
-		// AE\\d{21}
-		if (len != (2 + 21)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 21)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "AL", 2) == 0) {
-		// AL\\d{10}[A-Z0-9]{16}
-		if (len != (2 + 10 + 16)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 10) || !_nip24_isalnum(num, 12, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "AT", 2) == 0) {
-		// AT\\d{18}
-		if (len != (2 + 18)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 18)) {
-			goto err;
-		}
+	if (!isupper(num[0]) || !isupper(num[1])) {
+		return FALSE;
 	}
-	else if (strncmp(num, "AZ", 2) == 0) {
-		// AZ\\d{2}[A-Z]{4}[A-Z0-9]{20}
-		if (len != (2 + 2 + 4 + 20)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "BA", 2) == 0) {
-		// BA\\d{18}
-		if (len != (2 + 18)) {
-			goto err;
-		}
+	f = &_nip24_iban_formats[COUNTRY2IDX(num[0], num[1])];
 
-		if (!_nip24_isdigit(num, 2, 18)) {
-			goto err;
-		}
+	if (f->length == 0 || len != f->length) {
+		return FALSE;
 	}
-	else if (strncmp(num, "BE", 2) == 0) {
-		// BE\\d{14}
-		if (len != (2 + 14)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 14)) {
-			goto err;
-		}
+	if (!_nip24_check_runs(num, 2, f->run, RUNS_MAX, 0)) {
+		return FALSE;
 	}
-	else if (strncmp(num, "BG", 2) == 0) {
-		// BG\\d{2}[A-Z]{4}\\d{6}[A-Z0-9]{8}
-		if (len != (2 + 2 + 4 + 6 + 8)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 6) || !_nip24_isalnum(num, 14, 8)) {
-			goto err;
-		}
+	if (flags & NIP24_VALIDATE_NO_CHECKSUM) {
+		return TRUE;
 	}
-	else if (strncmp(num, "BH", 2) == 0) {
-		// BH\\d{2}[A-Z]{4}[A-Z0-9]{14}
-		if (len != (2 + 2 + 4 + 14)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 14)) {
-			goto err;
-		}
+	if ((flags & NIP24_VALIDATE_NATIONAL) && f->national && !f->national(num + 4, len - 4)) {
+		return FALSE;
 	}
-	else if (strncmp(num, "BR", 2) == 0) {
-		// BR\\d{25}[A-Z]{1}[A-Z0-9]{1}
-		if (len != (2 + 25 + 1 + 1)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 25) || !_nip24_isalpha(num, 27, 1) || !_nip24_isalnum(num, 28, 1)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "BY", 2) == 0) {
-		// BY\\d{2}[A-Z0-9]{4}\\d{4}[A-Z0-9]{16}
-		if (len != (2 + 2 + 4 + 4 + 16)) {
-			goto err;
-		}
+	// mod 97 z numeru przesunietego o 4 znaki, litery jako liczby 10-35,
+	// redukcja co 9 cyfr, aby wynik posredni miescil sie w 64 bitach
+	for (i = 0; i < len; i++) {
+		c = num[(i + 4) % len];
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalnum(num, 4, 4) || !_nip24_isdigit(num, 8, 4) || !_nip24_isalnum(num, 12, 16)) {
-			goto err;
+		if (isalpha(c)) {
+			chk = chk * 100 + (c - 55);
+			digits += 2;
 		}
-	}
-	else if (strncmp(num, "CH", 2) == 0) {
-		// CH\\d{7}[A-Z0-9]{12}
-		if (len != (2 + 7 + 12)) {
-			goto err;
+		else {
+			chk = chk * 10 + CHAR2NUM(c);
+			digits++;
 		}
 
-		if (!_nip24_isdigit(num, 2, 7) || !_nip24_isalnum(num, 9, 12)) {
-			goto err;
+		if (digits >= 9) {
+			chk %= 97;
+			digits = 0;
 		}
 	}
-	else if (strncmp(num, "CR", 2) == 0) {
-		// CR\\d{20}
-		if (len != (2 + 20)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "CY", 2) == 0) {
-		// CY\\d{10}[A-Z0-9]{16}
-		if (len != (2 + 10 + 16)) {
-			goto err;
-		}
+	return (chk % 97 == 1 ? TRUE : FALSE);
+}
 
-		if (!_nip24_isdigit(num, 2, 10) || !_nip24_isalnum(num, 12, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "CZ", 2) == 0) {
-		// CZ\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
-		}
+NIP24_API BOOL nip24_iban_is_valid(const char* iban)
+{
+	char num[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "DE", 2) == 0) {
-		// DE\\d{20}
-		if (len != (2 + 20)) {
-			goto err;
-		}
+	return nip24_number_check(IBAN, iban, num, sizeof(num));
+}
 
-		if (!_nip24_isdigit(num, 2, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "DK", 2) == 0) {
-		// DK\\d{16}
-		if (len != (2 + 16)) {
-			goto err;
-		}
+NIP24_API BOOL nip24_iban_is_valid_ex(const char* iban, int flags)
+{
+	char num[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 2, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "DO", 2) == 0) {
-		// DO\\d{2}[A-Z0-9]{4}\\d{20}
-		if (len != (2 + 2 + 4 + 20)) {
-			goto err;
-		}
+	return (nip24_iban_normalize_into(iban, num, sizeof(num)) && _nip24_iban_is_valid(num, flags));
+}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalnum(num, 4, 4) || !_nip24_isdigit(num, 8, 20)) {
-			goto err;
-		}
+NIP24_API BOOL nip24_number_check(Number type, const char* number, char* out, size_t size)
+{
+	if (type == NIP) {
+		return _nip24_nip_check(number, out, size);
 	}
-	else if (strncmp(num, "EE", 2) == 0) {
-		// EE\\d{18}
-		if (len != (2 + 18)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 18)) {
-			goto err;
-		}
+	else if (type == REGON) {
+		return _nip24_regon_check(number, out, size);
 	}
-	else if (strncmp(num, "ES", 2) == 0) {
-		// ES\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
-		}
+	else if (type == KRS) {
+		return nip24_krs_normalize_into(number, out, size);
 	}
-	else if (strncmp(num, "FI", 2) == 0) {
-		// FI\\d{16}
-		if (len != (2 + 16)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 16)) {
-			goto err;
-		}
+	else if (type == EUVAT) {
+		return (nip24_euvat_normalize_into(number, out, size) && _nip24_euvat_is_valid(out, 0));
 	}
-	else if (strncmp(num, "FO", 2) == 0) {
-		// FO\\d{16}
-		if (len != (2 + 16)) {
-			goto err;
-		}
-
-		if (!_nip24_isdigit(num, 2, 16)) {
-			goto err;
-		}
+	else if (type == IBAN) {
+		return (nip24_iban_normalize_into(number, out, size) && _nip24_iban_is_valid(out, 0));
 	}
-	else if (strncmp(num, "FR", 2) == 0) {
-		// FR\\d{12}[A-Z0-9]{11}\\d{2}
-		if (len != (2 + 12 + 11 + 2)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 12) || !_nip24_isalnum(num, 14, 11) || !_nip24_isdigit(num, 25, 2)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "GB", 2) == 0) {
-		// GB\\d{2}[A-Z]{4}\\d{14}
-		if (len != (2 + 2 + 4 + 14)) {
-			goto err;
-		}
+	return FALSE;
+}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 14)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "GE", 2) == 0) {
-		// GE\\d{2}[A-Z]{2}\\d{16}
-		if (len != (2 + 2 + 2 + 16)) {
-			goto err;
-		}
+NIP24_API int nip24_detect_number_type(const char* number, Number* candidates, int size)
+{
+	char num[MAX_NUMBER];
+	char out[MAX_NUMBER];
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 2) || !_nip24_isdigit(num, 6, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "GI", 2) == 0) {
-		// GI\\d{2}[A-Z]{4}[A-Z0-9]{15}
-		if (len != (2 + 2 + 4 + 15)) {
-			goto err;
-		}
+	int digits = 0;
+	int letters = 0;
+	int n = 0;
+	int len;
+	int p;
+	int i;
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 15)) {
-			goto err;
-		}
+	if (!number || !candidates || size <= 0 || (len = (int)strlen(number)) == 0) {
+		return 0;
 	}
-	else if (strncmp(num, "GL", 2) == 0) {
-		// GL\\d{16}
-		if (len != (2 + 16)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "GR", 2) == 0) {
-		// GR\\d{9}[A-Z0-9]{16}
-		if (len != (2 + 9 + 16)) {
-			goto err;
+	// jedno przejscie: klasy znakow i postac bez separatorow
+	for (i = 0, p = 0; i < len; i++) {
+		if (isdigit(number[i])) {
+			digits++;
 		}
-
-		if (!_nip24_isdigit(num, 2, 9) || !_nip24_isalnum(num, 11, 16)) {
-			goto err;
+		else if (isalpha(number[i])) {
+			letters++;
 		}
-	}
-	else if (strncmp(num, "GT", 2) == 0) {
-		// GT\\d{2}[A-Z0-9]{24}
-		if (len != (2 + 2 + 24)) {
-			goto err;
+		else if (number[i] != '+' && number[i] != '*') {
+			continue;
 		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalnum(num, 4, 24)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "HR", 2) == 0) {
-		// HR\\d{19}
-		if (len != (2 + 19)) {
-			goto err;
+		if (p == sizeof(num) - 1) {
+			return 0;
 		}
 
-		if (!_nip24_isdigit(num, 2, 19)) {
-			goto err;
-		}
+		num[p++] = toupper(number[i]);
 	}
-	else if (strncmp(num, "HU", 2) == 0) {
-		// HU\\d{26}
-		if (len != (2 + 26)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 26)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "IE", 2) == 0) {
-		// IE\\d{2}[A-Z]{4}\\d{14}
-		if (len != (2 + 2 + 4 + 14)) {
-			goto err;
-		}
+	num[p] = '\0';
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 14)) {
-			goto err;
-		}
+	if (p == 0) {
+		return 0;
 	}
-	else if (strncmp(num, "IL", 2) == 0) {
-		// IL\\d{21}
-		if (len != (2 + 21)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 21)) {
-			goto err;
+	// najpierw typy potwierdzone suma kontrolna, na koncu KRS (tylko format)
+	// numery IBAN tylko z kodem kraju - nip24_number_check(IBAN, ...) nie dodaje prefiksu PL
+	if (digits == p) {
+		if (p == 10 && _nip24_nip_check(num, out, sizeof(out)) && n < size) {
+			candidates[n++] = NIP;
 		}
-	}
-	else if (strncmp(num, "IQ", 2) == 0) {
-		// IQ\\d{2}[A-Z]{4}\\d{15}
-		if (len != (2 + 2 + 4 + 15)) {
-			goto err;
+		else if ((p == 9 || p == 14) && _nip24_regon_check(num, out, sizeof(out)) && n < size) {
+			candidates[n++] = REGON;
 		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 15)) {
-			goto err;
+		if (p <= 10 && nip24_number_check(KRS, number, out, sizeof(out)) && n < size) {
+			candidates[n++] = KRS;
 		}
 	}
-	else if (strncmp(num, "IS", 2) == 0) {
-		// IS\\d{24}
-		if (len != (2 + 24)) {
-			goto err;
+	else if (p >= 4 && isalpha(num[0]) && isalpha(num[1])) {
+		if (digits + letters == p && p >= 15 && p <= 32 && _nip24_iban_is_valid(num, 0) && n < size) {
+			candidates[n++] = IBAN;
 		}
 
-		if (!_nip24_isdigit(num, 2, 24)) {
-			goto err;
+		if (p <= 14 && _nip24_euvat_is_valid(num, 0) && n < size) {
+			candidates[n++] = EUVAT;
 		}
 	}
-	else if (strncmp(num, "IT", 2) == 0) {
-		// IT\\d{2}[A-Z]{1}\\d{10}[A-Z0-9]{12}
-		if (len != (2 + 2 + 1 + 10 + 12)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 1) || !_nip24_isdigit(num, 5, 10) || !_nip24_isalnum(num, 15, 12)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "JO", 2) == 0) {
-		// JO\\d{2}[A-Z]{4}\\d{4}[A-Z0-9]{18}
-		if (len != (2 + 2 + 4 + 4 + 18)) {
-			goto err;
-		}
+	return n;
+}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 4) || !_nip24_isalnum(num, 12, 18)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "KW", 2) == 0) {
-		// KW\\d{2}[A-Z]{4}[A-Z0-9]{22}
-		if (len != (2 + 2 + 4 + 22)) {
-			goto err;
-		}
+/////////////////////////////////////////////////////////////////
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 22)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "KZ", 2) == 0) {
-		// KZ\\d{5}[A-Z0-9]{13}
-		if (len != (2 + 5 + 13)) {
-			goto err;
-		}
+#define BATCH_ROWS		8
+#define BATCH_DIGITS	16
 
-		if (!_nip24_isdigit(num, 2, 5) || !_nip24_isalnum(num, 7, 13)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LB", 2) == 0) {
-		// LB\\d{6}[A-Z0-9]{20}
-		if (len != (2 + 6 + 20)) {
-			goto err;
-		}
+/**
+ * Sumy wazone cyfr dla BATCH_ROWS numerow (wiersze po BATCH_DIGITS cyfr)
+ */
+typedef void (*WeightedSums)(const unsigned char* digits, const signed char* w, int* sum);
 
-		if (!_nip24_isdigit(num, 2, 6) || !_nip24_isalnum(num, 8, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LC", 2) == 0) {
-		// LC\\d{2}[A-Z]{4}[A-Z0-9]{24}
-		if (len != (2 + 2 + 4 + 24)) {
-			goto err;
-		}
+static const signed char _nip24_nip_w[BATCH_DIGITS] = {
+	6, 5, 7, 2, 3, 4, 5, 6, 7
+};
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 24)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LI", 2) == 0) {
-		// LI\\d{7}[A-Z0-9]{12}
-		if (len != (2 + 7 + 12)) {
-			goto err;
-		}
+static const signed char _nip24_regon_w9[BATCH_DIGITS] = {
+	8, 9, 2, 3, 4, 5, 6, 7
+};
 
-		if (!_nip24_isdigit(num, 2, 7) || !_nip24_isalnum(num, 9, 12)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LT", 2) == 0) {
-		// LT\\d{18}
-		if (len != (2 + 18)) {
-			goto err;
-		}
+static const signed char _nip24_regon_w14[BATCH_DIGITS] = {
+	2, 4, 8, 5, 0, 9, 7, 3, 6, 1, 2, 4, 8
+};
 
-		if (!_nip24_isdigit(num, 2, 18)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "LU", 2) == 0) {
-		// LU\\d{5}[A-Z0-9]{13}
-		if (len != (2 + 5 + 13)) {
-			goto err;
-		}
+static int _nip24_digits(const char* num, int min, int max, unsigned char* out)
+{
+	int len;
+	int p;
+	int i;
 
-		if (!_nip24_isdigit(num, 2, 5) || !_nip24_isalnum(num, 7, 13)) {
-			goto err;
-		}
+	if (!num || (len = (int)strlen(num)) < min || len > max) {
+		return -1;
 	}
-	else if (strncmp(num, "LV", 2) == 0) {
-		// LV\\d{2}[A-Z]{4}[A-Z0-9]{13}
-		if (len != (2 + 2 + 4 + 13)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 13)) {
-			goto err;
+	// max < BATCH_DIGITS, wiec wiersz nie moze sie przepelnic
+	for (i = 0, p = 0; i < len; i++) {
+		if (isdigit(num[i])) {
+			out[p++] = (unsigned char)CHAR2NUM(num[i]);
 		}
 	}
-	else if (strncmp(num, "MC", 2) == 0) {
-		// MC\\d{12}[A-Z0-9]{11}\\d{2}
-		if (len != (2 + 12 + 11 + 2)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 12) || !_nip24_isalnum(num, 14, 11) || !_nip24_isdigit(num, 25, 2)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "MD", 2) == 0) {
-		// MD\\d{2}[A-Z0-9]{20}
-		if (len != (2 + 2 + 20)) {
-			goto err;
-		}
+	return p;
+}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalnum(num, 4, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "ME", 2) == 0) {
-		// ME\\d{20}
-		if (len != (2 + 20)) {
-			goto err;
-		}
+static void _nip24_weighted_sums_scalar(const unsigned char* digits, const signed char* w, int* sum)
+{
+	int r;
+	int i;
 
-		if (!_nip24_isdigit(num, 2, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "MK", 2) == 0) {
-		// MK\\d{5}[A-Z0-9]{10}\\d{2}
-		if (len != (2 + 5 + 10 + 2)) {
-			goto err;
-		}
+	for (r = 0; r < BATCH_ROWS; r++, digits += BATCH_DIGITS) {
+		sum[r] = 0;
 
-		if (!_nip24_isdigit(num, 2, 5) || !_nip24_isalnum(num, 7, 10) || !_nip24_isdigit(num, 17, 2)) {
-			goto err;
+		for (i = 0; i < BATCH_DIGITS; i++) {
+			sum[r] += digits[i] * w[i];
 		}
 	}
-	else if (strncmp(num, "MR", 2) == 0) {
-		// MR\\d{25}
-		if (len != (2 + 25)) {
-			goto err;
-		}
+}
 
-		if (!_nip24_isdigit(num, 2, 25)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "MT", 2) == 0) {
-		// MT\\d{2}[A-Z]{4}\\d{5}[A-Z0-9]{18}
-		if (len != (2 + 2 + 4 + 5 + 18)) {
-			goto err;
-		}
+#if defined(_M_X64) || defined(_M_IX86)
+static void _nip24_weighted_sums_avx2(const unsigned char* digits, const signed char* w, int* sum)
+{
+	__m256i wv = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)w));
+	__m256i ones = _mm256_set1_epi16(1);
+	__m256i r[BATCH_ROWS / 2];
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 5) || !_nip24_isalnum(num, 13, 18)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "MU", 2) == 0) {
-		// MU\\d{2}[A-Z]{4}\\d{19}[A-Z]{3}
-		if (len != (2 + 2 + 4 + 19 + 3)) {
-			goto err;
-		}
+	int k;
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 19) || !_nip24_isalpha(num, 27, 3)) {
-			goto err;
-		}
+	// dwa wiersze na rejestr: iloczyny cyfr i wag sumowane do 4 x int32 na wiersz
+	for (k = 0; k < BATCH_ROWS / 2; k++) {
+		r[k] = _mm256_loadu_si256((const __m256i*)(digits + 2 * k * BATCH_DIGITS));
+		r[k] = _mm256_madd_epi16(_mm256_maddubs_epi16(r[k], wv), ones);
 	}
-	else if (strncmp(num, "NL", 2) == 0) {
-		// NL\\d{2}[A-Z]{4}\\d{10}
-		if (len != (2 + 2 + 4 + 10)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 10)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "NO", 2) == 0) {
-		// NO\\d{13}
-		if (len != (2 + 13)) {
-			goto err;
-		}
+	// po dwoch hadd: polowka 0 = wiersze 0, 2, 4, 6; polowka 1 = wiersze 1, 3, 5, 7
+	r[0] = _mm256_hadd_epi32(_mm256_hadd_epi32(r[0], r[1]), _mm256_hadd_epi32(r[2], r[3]));
+	r[0] = _mm256_permutevar8x32_epi32(r[0], _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
 
-		if (!_nip24_isdigit(num, 2, 13)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "PK", 2) == 0) {
-		// PK\\d{2}[A-Z]{4}[A-Z0-9]{16}
-		if (len != (2 + 2 + 4 + 16)) {
-			goto err;
-		}
+	_mm256_storeu_si256((__m256i*)sum, r[0]);
+}
+#endif
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "PL", 2) == 0) {
-		// PL\\d{26}
-		if (len != (2 + 26)) {
-			goto err;
-		}
+static WeightedSums _nip24_weighted_sums_impl(void)
+{
+	static WeightedSums impl;
 
-		if (!_nip24_isdigit(num, 2, 26)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "PS", 2) == 0) {
-		// PS\\d{2}[A-Z]{4}[A-Z0-9]{21}
-		if (len != (2 + 2 + 4 + 21)) {
-			goto err;
-		}
+#if defined(_M_X64) || defined(_M_IX86)
+	int info[4];
+#endif
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 21)) {
-			goto err;
-		}
+	if (impl) {
+		return impl;
 	}
-	else if (strncmp(num, "PT", 2) == 0) {
-		// PT\\d{23}
-		if (len != (2 + 23)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 23)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "QA", 2) == 0) {
-		// QA\\d{2}[A-Z]{4}[A-Z0-9]{21}
-		if (len != (2 + 2 + 4 + 21)) {
-			goto err;
-		}
+#if defined(_M_X64) || defined(_M_IX86)
+	__cpuid(info, 0);
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 21)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "RO", 2) == 0) {
-		// RO\\d{2}[A-Z]{4}[A-Z0-9]{16}
-		if (len != (2 + 2 + 4 + 16)) {
-			goto err;
-		}
+	if (info[0] >= 7) {
+		__cpuid(info, 1);
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isalnum(num, 8, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "RS", 2) == 0) {
-		// RS\\d{20}
-		if (len != (2 + 20)) {
-			goto err;
-		}
+		// OSXSAVE i AVX, system zachowuje rejestry YMM, AVX2
+		if ((info[2] & (3 << 27)) == (3 << 27) && (_xgetbv(0) & 6) == 6) {
+			__cpuidex(info, 7, 0);
 
-		if (!_nip24_isdigit(num, 2, 20)) {
-			goto err;
+			if (info[1] & (1 << 5)) {
+				impl = _nip24_weighted_sums_avx2;
+				return impl;
+			}
 		}
 	}
-	else if (strncmp(num, "SA", 2) == 0) {
-		// SA\\d{4}[A-Z0-9]{18}
-		if (len != (2 + 4 + 18)) {
-			goto err;
-		}
+#endif
 
-		if (!_nip24_isdigit(num, 2, 4) || !_nip24_isalnum(num, 6, 18)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SC", 2) == 0) {
-		// SC\\d{2}[A-Z]{4}\\d{20}[A-Z]{3}
-		if (len != (2 + 2 + 4 + 20 + 3)) {
-			goto err;
-		}
+	impl = _nip24_weighted_sums_scalar;
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 20) || !_nip24_isalpha(num, 28, 3)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SE", 2) == 0) {
-		// SE\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
-		}
+	return impl;
+}
 
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SI", 2) == 0) {
-		// SI\\d{17}
-		if (len != (2 + 17)) {
-			goto err;
-		}
+static size_t _nip24_checksum_batch(Number type, const char* const* in, size_t n, uint8_t* ok)
+{
+	unsigned char digits[BATCH_ROWS][BATCH_DIGITS];
 
-		if (!_nip24_isdigit(num, 2, 17)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SK", 2) == 0) {
-		// SK\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
-		}
+	int len[BATCH_ROWS];
+	int sum[BATCH_ROWS];
+	int sum14[BATCH_ROWS];
 
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SM", 2) == 0) {
-		// SM\\d{2}[A-Z]{1}\\d{10}[A-Z0-9]{12}
-		if (len != (2 + 2 + 1 + 10 + 12)) {
-			goto err;
-		}
+	WeightedSums ws = _nip24_weighted_sums_impl();
+	size_t valid = 0;
+	size_t i;
+	BOOL v;
+	int m;
+	int k;
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 1) || !_nip24_isdigit(num, 5, 10) || !_nip24_isalnum(num, 15, 12)) {
-			goto err;
-		}
+	if (!in || !ok) {
+		return 0;
 	}
-	else if (strncmp(num, "ST", 2) == 0) {
-		// ST\\d{23}
-		if (len != (2 + 23)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 23)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "SV", 2) == 0) {
-		// SV\\d{2}[A-Z]{4}\\d{20}
-		if (len != (2 + 2 + 4 + 20)) {
-			goto err;
-		}
+	for (i = 0; i < n; i += m) {
+		m = (int)(n - i < BATCH_ROWS ? n - i : BATCH_ROWS);
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 20)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "TL", 2) == 0) {
-		// TL\\d{21}
-		if (len != (2 + 21)) {
-			goto err;
-		}
+		memset(digits, 0, sizeof(digits));
 
-		if (!_nip24_isdigit(num, 2, 21)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "TN", 2) == 0) {
-		// TN\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
+		for (k = 0; k < m; k++) {
+			len[k] = (type == NIP ? _nip24_digits(in[i + k], 10, 13, digits[k])
+				: _nip24_digits(in[i + k], 9, 14, digits[k]));
 		}
 
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
+		if (type == NIP) {
+			ws(&digits[0][0], _nip24_nip_w, sum);
 		}
-	}
-	else if (strncmp(num, "TN", 2) == 0) {
-		// TN\\d{22}
-		if (len != (2 + 22)) {
-			goto err;
+		else {
+			ws(&digits[0][0], _nip24_regon_w9, sum);
+			ws(&digits[0][0], _nip24_regon_w14, sum14);
 		}
 
-		if (!_nip24_isdigit(num, 2, 22)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "TR", 2) == 0) {
-		// TR\\d{8}[A-Z0-9]{16}
-		if (len != (2 + 8 + 16)) {
-			goto err;
-		}
+		for (k = 0; k < m; k++) {
+			if (type == NIP) {
+				v = (len[k] == 10 && (sum[k] % 11) == digits[k][9]);
+			}
+			else {
+				v = ((len[k] == 9 || len[k] == 14) && (sum[k] % 11) % 10 == digits[k][8]
+					&& (len[k] == 9 || (sum14[k] % 11) % 10 == digits[k][13]));
+			}
 
-		if (!_nip24_isdigit(num, 2, 8) || !_nip24_isalnum(num, 10, 16)) {
-			goto err;
+			ok[i + k] = (v ? 1 : 0);
+			valid += ok[i + k];
 		}
 	}
-	else if (strncmp(num, "UA", 2) == 0) {
-		// UA\\d{8}[A-Z0-9]{19}
-		if (len != (2 + 8 + 19)) {
-			goto err;
-		}
 
-		if (!_nip24_isdigit(num, 2, 8) || !_nip24_isalnum(num, 10, 19)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "VG", 2) == 0) {
-		// VG\\d{2}[A-Z]{4}\\d{16}
-		if (len != (2 + 2 + 4 + 16)) {
-			goto err;
-		}
+	return valid;
+}
 
-		if (!_nip24_isdigit(num, 2, 2) || !_nip24_isalpha(num, 4, 4) || !_nip24_isdigit(num, 8, 16)) {
-			goto err;
-		}
-	}
-	else if (strncmp(num, "XK", 2) == 0) {
-		// XK\\d{18}
-		if (len != (2 + 18)) {
-			goto err;
-		}
+NIP24_API size_t nip24_nip_validate_batch(const char* const* nip, size_t n, uint8_t* ok)
+{
+	return _nip24_checksum_batch(NIP, nip, n, ok);
+}
 
-		if (!_nip24_isdigit(num, 2, 18)) {
-			goto err;
-		}
-	}
-	else {
-		goto err;
-	}
+NIP24_API size_t nip24_regon_validate_batch(const char* const* regon, size_t n, uint8_t* ok)
+{
+	return _nip24_checksum_batch(REGON, regon, n, ok);
+}
 
-	memset(sb, 0, sizeof(sb));
-	memcpy(sb, num + 4, len - 4);
-	memcpy(sb + len - 4, num, 4);
+NIP24_API size_t nip24_iban_validate_batch(const char* const* iban, size_t n, uint8_t* ok)
+{
+	char num[MAX_NUMBER];
 
-	memset(str, 0, sizeof(str));
+	size_t valid = 0;
+	size_t i;
 
-	for (i = 0, p = 0; i < len; i++) {
-		if (isalpha(sb[i])) {
-			p += snprintf(str + p, sizeof(str), "%d", sb[i] - 55);
-		}
-		else {
-			p += snprintf(str + p, sizeof(str), "%c", sb[i]);
-		}
+	if (!iban || !ok) {
+		return 0;
 	}
 
-	len = (int)strlen(str);
-	chk = CHAR2NUM(str[0]);
-
-	for (i = 1; i < len; i++) {
-		chk *= 10;
-		chk += CHAR2NUM(str[i]);
-		chk %= 97;
+	// mod 97 zalezy od poprzedniej reszty, wiec wiersze sprawdzane sa kolejno
+	for (i = 0; i < n; i++) {
+		ok[i] = (nip24_iban_normalize_into(iban[i], num, sizeof(num)) && _nip24_iban_is_valid(num, 0) ? 1 : 0);
+		valid += ok[i];
 	}
 
-	ret = (chk == 1 ? TRUE : FALSE);
-
-err:
-	free(num);
-
-	return ret;
+	return valid;
 }
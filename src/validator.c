@@ -0,0 +1,521 @@
+/**
+ * Copyright 2015-2025 NETCAT (www.netcat.pl)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @author NETCAT <firma@netcat.pl>
+ * @copyright 2015-2025 NETCAT (www.netcat.pl)
+ * @license http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#pragma warning(disable: 4333 4996)
+
+#define _CRT_SECURE_NO_DEPRECATE
+#define _WIN32_WINNT	0x0400
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nip24.h"
+
+#define MAX_COLUMNS		16
+#define MAX_FIELDS		256
+#define MAX_THREADS		64
+#define MAX_FIELD		64
+
+#define MIN_CHUNK		(1024 * 1024)
+
+/**
+ * Konfiguracja walidacji: separator pol, pominiecie naglowka i typy numerow w kolumnach
+ */
+typedef struct Config {
+	char sep;
+	BOOL header;
+
+	int columns;
+	Number type[MAX_FIELDS];
+	int slot[MAX_FIELDS];
+} Config;
+
+/**
+ * Fragment pliku przetwarzany przez jeden watek, wyrownany do granic wierszy
+ */
+typedef struct Chunk {
+	const Config* cfg;
+
+	const char* start;
+	const char* end;
+
+	size_t first;
+	size_t rows;
+	size_t valid[MAX_COLUMNS];
+
+	char* out;
+	size_t len;
+	size_t size;
+
+	BOOL err;
+} Chunk;
+
+static double now()
+{
+	static LARGE_INTEGER freq;
+
+	LARGE_INTEGER cnt;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+
+	QueryPerformanceCounter(&cnt);
+
+	return (double)cnt.QuadPart / (double)freq.QuadPart;
+}
+
+static Number parse_type(const char* name)
+{
+	if (_stricmp(name, "nip") == 0) {
+		return NIP;
+	}
+	else if (_stricmp(name, "regon") == 0) {
+		return REGON;
+	}
+	else if (_stricmp(name, "krs") == 0) {
+		return KRS;
+	}
+	else if (_stricmp(name, "euvat") == 0) {
+		return EUVAT;
+	}
+	else if (_stricmp(name, "iban") == 0) {
+		return IBAN;
+	}
+
+	return (Number)0;
+}
+
+static BOOL reserve(Chunk* c, size_t n)
+{
+	char* out;
+	size_t size;
+
+	if (c->len + n <= c->size) {
+		return TRUE;
+	}
+
+	// bufor rosnie dwukrotnie, bez alokacji dla kazdego wiersza
+	for (size = (c->size ? c->size * 2 : 65536); size < c->len + n; size *= 2);
+
+	if ((out = (char*)realloc(c->out, size)) == NULL) {
+		return FALSE;
+	}
+
+	c->out = out;
+	c->size = size;
+
+	return TRUE;
+}
+
+static DWORD WINAPI count_rows(LPVOID param)
+{
+	Chunk* c = (Chunk*)param;
+
+	const char* p = c->start;
+	const char* eol;
+
+	c->rows = 0;
+
+	while (p < c->end && (eol = (const char*)memchr(p, '\n', c->end - p)) != NULL) {
+		c->rows++;
+		p = eol + 1;
+	}
+
+	// ostatni wiersz pliku bez znaku konca linii
+	if (p < c->end) {
+		c->rows++;
+	}
+
+	return 0;
+}
+
+/**
+ * Odczyt jednego pola wiersza zgodnie z RFC 4180: pole w cudzyslowach moze zawierac separator,
+ * a podwojny cudzyslow oznacza jeden znak. Zwraca dlugosc pola lub -1 gdy nie miesci sie w buforze
+ */
+static int parse_field(const char* f, const char* eol, char sep, char* field, int size, const char** next)
+{
+	const char* q = f;
+
+	int n = 0;
+
+	if (q < eol && *q == '"') {
+		for (q++; q < eol; q++) {
+			if (*q == '"') {
+				if (q + 1 < eol && q[1] == '"') {
+					q++;
+				}
+				else {
+					q++;
+					break;
+				}
+			}
+
+			if (n < size) {
+				field[n] = *q;
+			}
+
+			n++;
+		}
+	}
+
+	// pole bez cudzyslowow lub znaki po cudzyslowie zamykajacym az do separatora
+	for (; q < eol && *q != sep; q++) {
+		if (*q == '\r' && q + 1 == eol) {
+			continue;
+		}
+
+		if (n < size) {
+			field[n] = *q;
+		}
+
+		n++;
+	}
+
+	*next = q;
+
+	return (n < size ? n : -1);
+}
+
+static DWORD WINAPI validate_rows(LPVOID param)
+{
+	Chunk* c = (Chunk*)param;
+	const Config* cfg = c->cfg;
+
+	char field[MAX_FIELD];
+	char num[MAX_FIELD];
+	char digits[24];
+
+	unsigned char res[MAX_COLUMNS];
+
+	const char* p = c->start;
+	const char* eol;
+	const char* f;
+	const char* fe;
+
+	size_t row = c->first;
+	size_t r;
+	int col;
+	int n;
+	int k;
+
+	for (; p < c->end; p = eol + 1) {
+		if ((eol = (const char*)memchr(p, '\n', c->end - p)) == NULL) {
+			eol = c->end;
+		}
+
+		if (++row == 1 && cfg->header) {
+			continue;
+		}
+
+		memset(res, 0, sizeof(res));
+
+		// pola wiersza kopiowane do bufora na stosie
+		for (col = 0, f = p; f <= eol && col < MAX_FIELDS; col++, f = fe + 1) {
+			n = parse_field(f, eol, cfg->sep, field, (int)sizeof(field), &fe);
+
+			if (!cfg->type[col]) {
+				continue;
+			}
+
+			if (n > 0) {
+				field[n] = '\0';
+
+				res[cfg->slot[col]] = (nip24_number_check(cfg->type[col], field, num, sizeof(num)) ? 1 : 0);
+			}
+		}
+
+		if (!reserve(c, sizeof(digits) + 2 * cfg->columns + 1)) {
+			c->err = TRUE;
+			return 1;
+		}
+
+		// numer wiersza, a nastepnie 1/0 dla kazdej kolumny
+		for (r = row, n = 0; r > 0 || n == 0; r /= 10) {
+			digits[n++] = '0' + (char)(r % 10);
+		}
+
+		while (n > 0) {
+			c->out[c->len++] = digits[--n];
+		}
+
+		for (k = 0; k < cfg->columns; k++) {
+			c->out[c->len++] = cfg->sep;
+			c->out[c->len++] = (res[k] ? '1' : '0');
+			c->valid[k] += res[k];
+		}
+
+		c->out[c->len++] = '\n';
+	}
+
+	return 0;
+}
+
+static BOOL run(LPTHREAD_START_ROUTINE proc, Chunk* chunk, int count)
+{
+	HANDLE th[MAX_THREADS];
+
+	BOOL ret = FALSE;
+	int n;
+	int i;
+
+	for (n = 0; n < count; n++) {
+		if ((th[n] = CreateThread(NULL, 0, proc, &chunk[n], 0, NULL)) == NULL) {
+			goto err;
+		}
+	}
+
+	ret = TRUE;
+
+err:
+	if (n > 0) {
+		WaitForMultipleObjects(n, th, TRUE, INFINITE);
+	}
+
+	for (i = 0; i < n; i++) {
+		CloseHandle(th[i]);
+	}
+
+	return ret;
+}
+
+static void usage()
+{
+	fprintf(stderr, "Uzycie: validator [-s separator] [-H] -c kolumna:typ [-c kolumna:typ ...] plik [raport]\n");
+	fprintf(stderr, "  -s separator    separator pol (domyslnie ;)\n");
+	fprintf(stderr, "  -H              pierwszy wiersz jest naglowkiem\n");
+	fprintf(stderr, "  -c kolumna:typ  numer kolumny (od 1) i typ: nip, regon, krs, euvat, iban\n");
+	fprintf(stderr, "Raport: numer wiersza i 1/0 dla kazdej kolumny, w kolejnosci opcji -c\n");
+}
+
+int main(int argc, char* argv[])
+{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE map = NULL;
+
+	SYSTEM_INFO si;
+	LARGE_INTEGER size;
+
+	Config cfg;
+	Chunk* chunk = NULL;
+
+	const char* in = NULL;
+	const char* out = NULL;
+	const char* base = NULL;
+	const char* end;
+	const char* p;
+
+	FILE* fout = NULL;
+
+	size_t rows = 0;
+	size_t valid;
+	double start;
+	double t;
+
+	int threads = 0;
+	int ret = 1;
+	int col;
+	int i;
+	int k;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.sep = ';';
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			cfg.sep = argv[++i][0];
+		}
+		else if (strcmp(argv[i], "-H") == 0) {
+			cfg.header = TRUE;
+		}
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			i++;
+
+			if ((col = atoi(argv[i]) - 1) < 0 || col >= MAX_FIELDS || cfg.columns == MAX_COLUMNS
+				|| !strchr(argv[i], ':') || !(cfg.type[col] = parse_type(strchr(argv[i], ':') + 1))) {
+				fprintf(stderr, "Nieprawidlowa kolumna: %s\n", argv[i]);
+				goto err;
+			}
+
+			cfg.slot[col] = cfg.columns++;
+		}
+		else if (!in) {
+			in = argv[i];
+		}
+		else if (!out) {
+			out = argv[i];
+		}
+		else {
+			usage();
+			goto err;
+		}
+	}
+
+	if (!in || cfg.columns == 0) {
+		usage();
+		goto err;
+	}
+
+	start = now();
+
+	// plik wejsciowy mapowany w calosci do pamieci
+	if ((file = CreateFileA(in, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE) {
+		fprintf(stderr, "Nie mozna otworzyc pliku: %s\n", in);
+		goto err;
+	}
+
+	if (!GetFileSizeEx(file, &size)) {
+		fprintf(stderr, "Nie mozna odczytac rozmiaru pliku: %s\n", in);
+		goto err;
+	}
+
+	if (size.QuadPart > 0) {
+		if ((map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL
+			|| (base = (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+			fprintf(stderr, "Nie mozna zmapowac pliku: %s\n", in);
+			goto err;
+		}
+
+		// po jednym fragmencie na rdzen, nie mniejszym niz MIN_CHUNK
+		GetSystemInfo(&si);
+
+		threads = (int)si.dwNumberOfProcessors;
+
+		if (threads > MAX_THREADS) {
+			threads = MAX_THREADS;
+		}
+
+		if ((size_t)size.QuadPart / threads < MIN_CHUNK) {
+			threads = (int)((size_t)size.QuadPart / MIN_CHUNK) + 1;
+		}
+
+		if ((chunk = (Chunk*)calloc(threads, sizeof(Chunk))) == NULL) {
+			goto err;
+		}
+
+		end = base + (size_t)size.QuadPart;
+
+		for (i = 0, p = base; i < threads; i++) {
+			chunk[i].cfg = &cfg;
+			chunk[i].start = p;
+
+			if (i == threads - 1) {
+				p = end;
+			}
+			else {
+				p = base + (size_t)(size.QuadPart / threads * (i + 1));
+
+				if (p < chunk[i].start) {
+					p = chunk[i].start;
+				}
+
+				// koniec fragmentu przesuniety za najblizszy znak konca linii
+				if (p > base && p[-1] != '\n') {
+					p = (const char*)memchr(p, '\n', end - p);
+					p = (p ? p + 1 : end);
+				}
+			}
+
+			chunk[i].end = p;
+		}
+
+		// numery wierszy: najpierw liczba wierszy w kazdym fragmencie, potem walidacja
+		if (!run(count_rows, chunk, threads)) {
+			goto err;
+		}
+
+		for (i = 0; i < threads; i++) {
+			chunk[i].first = rows;
+			rows += chunk[i].rows;
+		}
+
+		if (!run(validate_rows, chunk, threads)) {
+			goto err;
+		}
+	}
+
+	if (!out) {
+		fout = stdout;
+	}
+	else if ((fout = fopen(out, "wb")) == NULL) {
+		fprintf(stderr, "Nie mozna utworzyc pliku: %s\n", out);
+		goto err;
+	}
+
+	for (i = 0; i < threads; i++) {
+		if (chunk[i].err) {
+			fprintf(stderr, "Brak pamieci\n");
+			goto err;
+		}
+
+		if (chunk[i].len > 0 && fwrite(chunk[i].out, 1, chunk[i].len, fout) != chunk[i].len) {
+			fprintf(stderr, "Blad zapisu raportu\n");
+			goto err;
+		}
+	}
+
+	t = now() - start;
+
+	fprintf(stderr, "Wiersze: %Iu, watki: %d, czas: %.3f s, %.1f MB/s\n", rows, threads, t,
+		(double)size.QuadPart / (1024 * 1024) / t);
+
+	for (k = 0; k < cfg.columns; k++) {
+		for (i = 0, valid = 0; i < threads; i++) {
+			valid += chunk[i].valid[k];
+		}
+
+		for (col = 0; col < MAX_FIELDS && !(cfg.type[col] && cfg.slot[col] == k); col++);
+
+		fprintf(stderr, "Kolumna %d: prawidlowe %Iu\n", col + 1, valid);
+	}
+
+	ret = 0;
+
+err:
+	if (fout && fout != stdout) {
+		fclose(fout);
+	}
+
+	if (chunk) {
+		for (i = 0; i < threads; i++) {
+			free(chunk[i].out);
+		}
+
+		free(chunk);
+	}
+
+	if (base) {
+		UnmapViewOfFile(base);
+	}
+
+	if (map) {
+		CloseHandle(map);
+	}
+
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+
+	return ret;
+}